@@ -0,0 +1,165 @@
+#ifndef PAINTING_ARENA_H
+#define PAINTING_ARENA_H
+
+#include <new>
+#include <vector>
+
+#include "figure.h"
+#include "telemetry.h"
+
+namespace Window {
+	/*!
+		\brief Memory used by the figure arena, in bytes
+		\version 1.0.0
+		\author Crinax
+	*/
+	struct ArenaStats {
+		size_t used;
+		size_t retained;
+		size_t peak;
+	};
+
+	/*!
+		\brief Storage for figures in fixed blocks that never move
+		\details Figures are taken from the free list first, then from the unused part
+			of the last block, so growth never copies figures and a figure keeps its
+			address until it is released. releaseAll() empties the arena at once and
+			keeps at most RETAINED_BLOCKS blocks for the next figures.
+		\version 1.1.0
+		\author Crinax
+	*/
+	class FigureArena {
+		public:
+			// Figures in one block
+			static const size_t BLOCK_SIZE = 4096;
+			// Blocks kept by releaseAll
+			static const size_t RETAINED_BLOCKS = 16;
+
+			FigureArena() {
+				this->block_count = 0;
+				this->next_slot = 0;
+				this->used = 0;
+				this->peak_blocks = 0;
+			}
+
+			~FigureArena() {
+				for (size_t b = 0; b < this->blocks.size(); b++) {
+					this->freeBlock(this->blocks[b]);
+				}
+			}
+
+			FigureArena(const FigureArena&) = delete;
+			FigureArena& operator=(const FigureArena&) = delete;
+
+			// Returns storage for one figure, its contents are undefined
+			Window::Figure* allocate() {
+				this->used++;
+
+				if (!this->free_slots.empty()) {
+					Window::Figure* figure = this->free_slots.back();
+
+					this->free_slots.pop_back();
+
+					return figure;
+				}
+
+				if (this->block_count == 0 || this->next_slot == Window::FigureArena::BLOCK_SIZE) {
+					this->addBlock();
+				}
+
+				return this->blocks[this->block_count - 1] + this->next_slot++;
+			}
+
+			/*!
+				\brief Return storage of the figure to the free list
+				\param [in] figure {Figure returned by allocate}
+			*/
+			void release(Window::Figure* figure) {
+				figure->is_initialized = false;
+				this->free_slots.push_back(figure);
+				this->used--;
+			}
+
+			/*!
+				\brief Release every figure at once
+				\details Blocks past RETAINED_BLOCKS are freed, the rest are reused from the start
+			*/
+			void releaseAll() {
+				size_t kept = this->blocks.size() < Window::FigureArena::RETAINED_BLOCKS
+					? this->blocks.size()
+					: Window::FigureArena::RETAINED_BLOCKS;
+
+				for (size_t b = kept; b < this->blocks.size(); b++) {
+					this->freeBlock(this->blocks[b]);
+				}
+
+				this->blocks.resize(kept);
+				this->free_slots.clear();
+				this->block_count = 0;
+				this->next_slot = 0;
+				this->used = 0;
+			}
+
+			// Returns number of figures taken from the arena
+			size_t countUsed() {
+				return this->used;
+			}
+
+			// Returns bytes of live figures, of allocated blocks and the most blocks ever allocated
+			Window::ArenaStats getStats() {
+				return {
+					this->used * sizeof(Window::Figure),
+					this->blocks.size() * Window::FigureArena::BLOCK_SIZE * sizeof(Window::Figure),
+					this->peak_blocks * Window::FigureArena::BLOCK_SIZE * sizeof(Window::Figure),
+				};
+			}
+
+		protected:
+			// All allocated blocks, the first block_count of them are in use
+			Window::TrackedVector<Window::Figure*, Window::MEMORY_FIGURES> blocks;
+			Window::TrackedVector<Window::Figure*, Window::MEMORY_FIGURES> free_slots;
+			size_t block_count;
+			size_t next_slot;
+			size_t used;
+			size_t peak_blocks;
+
+			// Start the next block, a retained one if there is any
+			void addBlock() {
+				if (this->block_count == this->blocks.size()) {
+					this->blocks.push_back(this->newBlock());
+				}
+
+				this->block_count++;
+				this->next_slot = 0;
+
+				if (this->blocks.size() > this->peak_blocks) {
+					this->peak_blocks = this->blocks.size();
+				}
+			}
+
+			// Block of empty figures in tracked memory
+			Window::Figure* newBlock() {
+				Window::Figure* block = (Window::Figure*)Window::MemoryTelemetry::getShared().allocate(
+					Window::FigureArena::BLOCK_SIZE * sizeof(Window::Figure),
+					Window::MEMORY_FIGURES
+				);
+
+				for (size_t f = 0; f < Window::FigureArena::BLOCK_SIZE; f++) {
+					new (block + f) Window::Figure();
+				}
+
+				return block;
+			}
+
+			// Figures are trivially destructible, so only the memory is returned
+			void freeBlock(Window::Figure* block) {
+				Window::MemoryTelemetry::getShared().deallocate(
+					block,
+					Window::FigureArena::BLOCK_SIZE * sizeof(Window::Figure),
+					Window::MEMORY_FIGURES
+				);
+			}
+	};
+};
+
+#endif
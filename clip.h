@@ -0,0 +1,207 @@
+#ifndef PAINTING_CLIP_H
+#define PAINTING_CLIP_H
+
+#include <math.h>
+
+#include "figure.h"
+
+namespace Window {
+	// Rectangle of window coords, right and bottom are outside of it
+	struct ClipRect {
+		int left;
+		int top;
+		int right;
+		int bottom;
+	};
+
+	// Where the figure is relative to the rectangle
+	enum ClipClass {
+		CLIP_OUTSIDE,
+		CLIP_INSIDE,
+		CLIP_CROSSING,
+	};
+
+	/*!
+		\brief Pixels past the rectangle where ends of clipped edges may stay
+		\details Edges ending inside the band keep their ends, so they are drawn with the
+			same pixels as unclipped ones and tiles of one picture join without seams.
+			Rectangle and band together fit in the 16-bit coords of GDI.
+	*/
+	const int CLIP_GUARD_BAND = 1 << 14;
+
+	// Pixels past the exact outline where drawn pixels may be, vertices are truncated and line pixels rounded
+	const int CLIP_ROUNDING = 2;
+
+	// Part of an edge of the figure that has to be drawn
+	struct ClipSegment {
+		Window::Point from;
+		Window::Point to;
+	};
+
+	/*!
+		\brief Classify the figure by its bounding circle
+		\details Figures which are inside or outside of the rectangle grown by the margin
+			need no clipping. Bounds are computed in double, so far or huge figures don't
+			overflow. The circle is grown by CLIP_ROUNDING.
+		\param [in] figure {The figure}
+		\param [in] rect {The rectangle}
+		\param [in] margin {Reach of the pen past the outline, in pixels}
+	*/
+	inline Window::ClipClass classifyFigure(Window::Figure& figure, const Window::ClipRect& rect, int margin) {
+		Window::Point center = figure.getPosition();
+		double radius = fabs((double)figure.getRadius()) + Window::CLIP_ROUNDING;
+		double left = (double)rect.left - margin;
+		double top = (double)rect.top - margin;
+		double right = (double)rect.right - 1 + margin;
+		double bottom = (double)rect.bottom - 1 + margin;
+
+		if (center.x + radius < left || center.x - radius > right || center.y + radius < top || center.y - radius > bottom) {
+			return Window::CLIP_OUTSIDE;
+		}
+
+		if (center.x - radius >= left && center.x + radius <= right && center.y - radius >= top && center.y + radius <= bottom) {
+			return Window::CLIP_INSIDE;
+		}
+
+		return Window::CLIP_CROSSING;
+	}
+
+	/*!
+		\brief Clip the segment to the box, Liang-Barsky
+		\details Ends are moved along the segment onto the box
+		\return False if no part of the segment is in the box
+	*/
+	inline bool clipSegment(double& x0, double& y0, double& x1, double& y1, double left, double top, double right, double bottom) {
+		double dx = x1 - x0;
+		double dy = y1 - y0;
+		double p[4] = { -dx, dx, -dy, dy };
+		double q[4] = { x0 - left, right - x0, y0 - top, bottom - y0 };
+		double first = 0;
+		double last = 1;
+
+		for (int side = 0; side < 4; side++) {
+			if (p[side] == 0) {
+				// Parallel to the side, so either always in or always out of it
+				if (q[side] < 0) {
+					return false;
+				}
+
+				continue;
+			}
+
+			double t = q[side] / p[side];
+
+			if (p[side] < 0) {
+				first = t > first ? t : first;
+			} else {
+				last = t < last ? t : last;
+			}
+		}
+
+		if (first > last) {
+			return false;
+		}
+
+		// Ends inside the box are kept bit for bit
+		if (last < 1) {
+			x1 = x0 + last * dx;
+			y1 = y0 + last * dy;
+		}
+
+		if (first > 0) {
+			x0 += first * dx;
+			y0 += first * dy;
+		}
+
+		return true;
+	}
+
+	/*!
+		\brief Returns parts of the outline of the figure to draw in the rectangle
+		\details Outlines inside the rectangle are returned edge by edge as getVertices
+			gives them. Outlines crossing its border are computed in double, edges missing
+			the rectangle grown by the margin and CLIP_ROUNDING are dropped exactly and the rest are cut at
+			CLIP_GUARD_BAND, so segments are small whatever the size and position of the
+			figure, and edges ending near the rectangle are the same as getVertices gives.
+		\param [in] figure {The figure}
+		\param [in] rect {The rectangle}
+		\param [in] margin {Reach of the pen past the outline, in pixels}
+		\param [out] segments {Buffer for MAX_VERTICES segments}
+		\return Number of segments
+	*/
+	inline int clipFigure(Window::Figure& figure, const Window::ClipRect& rect, int margin, Window::ClipSegment* segments) {
+		Window::ClipClass clip_class = Window::classifyFigure(figure, rect, margin);
+
+		if (!figure.is_initialized || clip_class == Window::CLIP_OUTSIDE) {
+			return 0;
+		}
+
+		if (clip_class == Window::CLIP_INSIDE) {
+			Window::Point vertices[Window::Figure::MAX_VERTICES];
+			int vertices_count = figure.getVertices(vertices);
+
+			for (int i = 0; i < vertices_count; i++) {
+				segments[i] = { vertices[i], vertices[(i + 1) % vertices_count] };
+			}
+
+			return vertices_count;
+		}
+
+		const Window::FigureTemplate* shape = figure.getTemplate();
+		Window::Point center = figure.getPosition();
+		double scaled_cos = figure.getRadius() * cos(figure.getAngle());
+		double scaled_sin = figure.getRadius() * sin(figure.getAngle());
+		double xs[Window::Figure::MAX_VERTICES];
+		double ys[Window::Figure::MAX_VERTICES];
+		int vertices_count = figure.countVertices();
+		int segment_count = 0;
+
+		for (int i = 0; i < vertices_count; i++) {
+			xs[i] = center.x + (scaled_cos * shape->cosines[i] - scaled_sin * shape->sines[i]);
+			ys[i] = center.y + (scaled_sin * shape->cosines[i] + scaled_cos * shape->sines[i]);
+		}
+
+		for (int i = 0; i < vertices_count; i++) {
+			int next = (i + 1) % vertices_count;
+			double x0 = xs[i];
+			double y0 = ys[i];
+			double x1 = xs[next];
+			double y1 = ys[next];
+
+			if (!Window::clipSegment(
+				x0,
+				y0,
+				x1,
+				y1,
+				(double)rect.left - margin - Window::CLIP_ROUNDING,
+				(double)rect.top - margin - Window::CLIP_ROUNDING,
+				(double)rect.right - 1 + margin + Window::CLIP_ROUNDING,
+				(double)rect.bottom - 1 + margin + Window::CLIP_ROUNDING
+			)) {
+				continue;
+			}
+
+			x0 = xs[i];
+			y0 = ys[i];
+			x1 = xs[next];
+			y1 = ys[next];
+
+			Window::clipSegment(
+				x0,
+				y0,
+				x1,
+				y1,
+				(double)rect.left - Window::CLIP_GUARD_BAND,
+				(double)rect.top - Window::CLIP_GUARD_BAND,
+				(double)rect.right + Window::CLIP_GUARD_BAND,
+				(double)rect.bottom + Window::CLIP_GUARD_BAND
+			);
+
+			segments[segment_count++] = { { (int)x0, (int)y0 }, { (int)x1, (int)y1 } };
+		}
+
+		return segment_count;
+	}
+};
+
+#endif
@@ -0,0 +1,452 @@
+#ifndef PAINTING_COMMANDS_H
+#define PAINTING_COMMANDS_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdexcept>
+
+#include "scene.h"
+
+namespace Window {
+	// Actions on the scene, the same the window does on keys and mouse buttons
+	enum CommandType {
+		COMMAND_CREATE,
+		COMMAND_GENERATE,
+		COMMAND_ROTATE,
+		COMMAND_ROTATE_ALL,
+		COMMAND_ROTATE_AROUND_SELECTED,
+		COMMAND_ROTATE_AROUND_POINT,
+		COMMAND_MOVE,
+		COMMAND_MOVE_TO_SELECTED,
+		COMMAND_NEXT,
+		COMMAND_PREV,
+		COMMAND_GROW,
+		COMMAND_SHRINK,
+		COMMAND_SELECT,
+		COMMAND_LOCK,
+		COMMAND_DELETE,
+		COMMAND_DELETE_ALL,
+		COMMAND_ATTACH,
+		COMMAND_DETACH,
+		COMMAND_PLACE,
+		COMMAND_SNAP,
+		COMMAND_COUNT,
+	};
+
+	// Names of commands in scripts, indexed by CommandType
+	const char* const command_names[Window::COMMAND_COUNT] = {
+		"create",
+		"generate",
+		"rotate",
+		"rotate-all",
+		"rotate-around",
+		"rotate-point",
+		"move",
+		"move-to-selected",
+		"next",
+		"prev",
+		"grow",
+		"shrink",
+		"select",
+		"lock",
+		"delete",
+		"delete-all",
+		"attach",
+		"detach",
+		"place",
+		"snap",
+	};
+
+	/*!
+		\brief One action on the scene with its arguments, unused arguments are zero
+		\version 1.0.0
+		\author Crinax
+	*/
+	struct SceneCommand {
+		Window::CommandType type;
+		// Center, target point or size of the generated area
+		Window::Point point = { 0, 0 };
+		double angle = 0;
+		int radius = 0;
+		int vertices_number = 0;
+		// Figures made by generate and the seed of their parameters
+		int count = 0;
+		unsigned seed = 0;
+	};
+
+	// Virtual-key codes of Win32 handled by the window, traces store them as is
+	const int KEY_BACK = 0x08;
+	const int KEY_TAB = 0x09;
+	const int KEY_SPACE = 0x20;
+	const int KEY_END = 0x23;
+	const int KEY_LEFT = 0x25;
+	const int KEY_UP = 0x26;
+	const int KEY_RIGHT = 0x27;
+	const int KEY_DOWN = 0x28;
+	const int KEY_INSERT = 0x2D;
+	const int KEY_DELETE = 0x2E;
+	const int KEY_F1 = 0x70;
+	const int KEY_F2 = 0x71;
+	const int KEY_F3 = 0x72;
+	const int KEY_F4 = 0x73;
+	const int KEY_F5 = 0x74;
+	const int KEY_F6 = 0x75;
+	const int KEY_F7 = 0x76;
+	const int KEY_F8 = 0x77;
+	const int KEY_F9 = 0x78;
+	const int KEY_F11 = 0x7A;
+	const int KEY_F12 = 0x7B;
+
+	// Kinds of input the window turns into commands
+	enum InputType {
+		INPUT_KEY = 1,
+		INPUT_LEFT_BUTTON,
+		INPUT_MIDDLE_BUTTON,
+		INPUT_RIGHT_BUTTON,
+	};
+
+	/*!
+		\brief Key press or mouse click as WndProc sees it
+		\version 1.0.0
+		\author Crinax
+	*/
+	struct InputEvent {
+		Window::InputType type;
+		// Virtual-key code of INPUT_KEY
+		int key = 0;
+		// Mouse coords of buttons, LOWORD and HIWORD of lParam
+		Window::Point point = { 0, 0 };
+	};
+
+	// Most commands one input event turns into
+	const int MAX_EVENT_COMMANDS = 2;
+
+	/*!
+		\brief Returns commands the window runs for the input event
+		\param [in] event {The event}
+		\param [out] commands {MAX_EVENT_COMMANDS commands at most}
+		\return Number of commands, 0 if the window ignores the event
+	*/
+	inline int getEventCommands(const Window::InputEvent& event, Window::SceneCommand* commands) {
+		commands[0] = Window::SceneCommand();
+
+		switch (event.type) {
+			case Window::INPUT_LEFT_BUTTON:
+				commands[0] = { Window::COMMAND_PLACE, event.point };
+				return 1;
+
+			case Window::INPUT_MIDDLE_BUTTON:
+				commands[0] = { Window::COMMAND_MOVE_TO_SELECTED };
+				return 1;
+
+			case Window::INPUT_RIGHT_BUTTON:
+				commands[0] = { Window::COMMAND_ROTATE, { 0, 0 }, Window::pi };
+				commands[1] = { Window::COMMAND_ROTATE_AROUND_POINT, event.point, Window::pi };
+				return 2;
+
+			case Window::INPUT_KEY:
+				break;
+
+			default:
+				return 0;
+		}
+
+		switch (event.key) {
+			case Window::KEY_F1:
+				commands[0] = { Window::COMMAND_CREATE, { 100, 100 }, Window::pi, 50, 3 };
+				return 1;
+
+			case Window::KEY_F2:
+				commands[0] = { Window::COMMAND_CREATE, { 200, 200 }, Window::pi, 50, 4 };
+				return 1;
+
+			case Window::KEY_F3:
+				commands[0] = { Window::COMMAND_CREATE, { 300, 300 }, Window::pi / 4, 50, 4 };
+				return 1;
+
+			case Window::KEY_F4:
+				commands[0] = { Window::COMMAND_CREATE, { 300, 300 }, 0, 50, 6 };
+				return 1;
+
+			case Window::KEY_F5:
+				commands[0] = { Window::COMMAND_ROTATE_ALL, { 0, 0 }, -Window::rotate_angle };
+				return 1;
+
+			case Window::KEY_F6:
+				commands[0] = { Window::COMMAND_ROTATE_ALL, { 0, 0 }, Window::rotate_angle };
+				return 1;
+
+			case Window::KEY_F7:
+				commands[0] = { Window::COMMAND_ROTATE_AROUND_SELECTED, { 0, 0 }, -Window::rotate_angle };
+				return 1;
+
+			case Window::KEY_F8:
+				commands[0] = { Window::COMMAND_ROTATE_AROUND_SELECTED, { 0, 0 }, Window::rotate_angle };
+				return 1;
+
+			case Window::KEY_F9:
+				commands[0] = { Window::COMMAND_LOCK };
+				return 1;
+
+			case Window::KEY_F11:
+				commands[0] = { Window::COMMAND_ROTATE, { 0, 0 }, -Window::rotate_angle };
+				return 1;
+
+			case Window::KEY_F12:
+				commands[0] = { Window::COMMAND_ROTATE, { 0, 0 }, Window::rotate_angle };
+				return 1;
+
+			case Window::KEY_SPACE:
+				commands[0] = { Window::COMMAND_SELECT };
+				return 1;
+
+			case Window::KEY_LEFT:
+				commands[0] = { Window::COMMAND_PREV };
+				return 1;
+
+			case Window::KEY_RIGHT:
+				commands[0] = { Window::COMMAND_NEXT };
+				return 1;
+
+			case Window::KEY_UP:
+				commands[0] = { Window::COMMAND_GROW };
+				return 1;
+
+			case Window::KEY_DOWN:
+				commands[0] = { Window::COMMAND_SHRINK };
+				return 1;
+
+			case Window::KEY_DELETE:
+				commands[0] = { Window::COMMAND_DELETE };
+				return 1;
+
+			case Window::KEY_INSERT:
+				commands[0] = { Window::COMMAND_ATTACH };
+				return 1;
+
+			case Window::KEY_END:
+				commands[0] = { Window::COMMAND_DETACH };
+				return 1;
+
+			case Window::KEY_BACK:
+				commands[0] = { Window::COMMAND_DELETE_ALL };
+				return 1;
+
+			case Window::KEY_TAB:
+				commands[0] = { Window::COMMAND_SNAP };
+				return 1;
+		}
+
+		return 0;
+	}
+
+	/*!
+		\brief Parse one line of a script
+		\details Line is a command name and its arguments separated by spaces, angles are
+			in radians. Empty lines and lines starting with # hold no command.
+
+			create <vertices> <x> <y> <radius> [angle]
+			generate <count> <width> <height> [seed]
+			rotate <angle>, rotate-all <angle>, rotate-around <angle>
+			rotate-point <x> <y> <angle>
+			move <x> <y>, place <x> <y>
+			move-to-selected, next, prev, grow, shrink, select, lock,
+			delete, delete-all, attach, detach, snap
+		\param [in] line {The line, without or with the line break}
+		\param [out] command {The command}
+		\return false if the line holds no command, throws if it is malformed
+	*/
+	inline bool parseCommand(const char* line, Window::SceneCommand& command) {
+		char name[32];
+		int offset = 0;
+
+		if (sscanf(line, " %31s%n", name, &offset) != 1 || name[0] == '#') {
+			return false;
+		}
+
+		int type = 0;
+
+		while (type < Window::COMMAND_COUNT && strcmp(name, Window::command_names[type]) != 0) {
+			type++;
+		}
+
+		if (type == Window::COMMAND_COUNT) {
+			throw std::runtime_error("[ERR] Window::parseCommand: unknown command");
+		}
+
+		const char* arguments = line + offset;
+		bool is_valid = true;
+
+		command = Window::SceneCommand();
+		command.type = (Window::CommandType)type;
+
+		switch (command.type) {
+			case Window::COMMAND_CREATE:
+				is_valid = sscanf(
+					arguments,
+					"%d %d %d %d %lf",
+					&command.vertices_number,
+					&command.point.x,
+					&command.point.y,
+					&command.radius,
+					&command.angle
+				) >= 4;
+				break;
+
+			case Window::COMMAND_GENERATE:
+				is_valid = sscanf(arguments, "%d %d %d %u", &command.count, &command.point.x, &command.point.y, &command.seed) >= 3;
+				break;
+
+			case Window::COMMAND_ROTATE:
+			case Window::COMMAND_ROTATE_ALL:
+			case Window::COMMAND_ROTATE_AROUND_SELECTED:
+				is_valid = sscanf(arguments, "%lf", &command.angle) == 1;
+				break;
+
+			case Window::COMMAND_ROTATE_AROUND_POINT:
+				is_valid = sscanf(arguments, "%d %d %lf", &command.point.x, &command.point.y, &command.angle) == 3;
+				break;
+
+			case Window::COMMAND_MOVE:
+			case Window::COMMAND_PLACE:
+				is_valid = sscanf(arguments, "%d %d", &command.point.x, &command.point.y) == 2;
+				break;
+
+			default:
+				break;
+		}
+
+		if (!is_valid) {
+			throw std::runtime_error("[ERR] Window::parseCommand: wrong arguments");
+		}
+
+		return true;
+	}
+
+	/*!
+		\brief Apply the command to the scene, errors of the scene are thrown as is
+		\param [in] scene {The scene}
+		\param [in] command {The command}
+	*/
+	inline void applyCommand(Window::Scene& scene, const Window::SceneCommand& command) {
+		switch (command.type) {
+			case Window::COMMAND_CREATE:
+				scene.newFigure(command.point, command.radius, command.vertices_number, command.angle, true);
+				break;
+
+			case Window::COMMAND_GENERATE: {
+				// Figures with 3..10 vertices and radius 5..24 in [0, width) x [0, height)
+				unsigned state = command.seed;
+				int left = command.count;
+				int width = command.point.x > 0 ? command.point.x : 1;
+				int height = command.point.y > 0 ? command.point.y : 1;
+
+				scene.newFiguresFrom([&](Window::FigureSpec& spec) {
+					if (left-- <= 0) {
+						return false;
+					}
+
+					unsigned values[4];
+
+					for (int v = 0; v < 4; v++) {
+						state = state * 1664525u + 1013904223u;
+						values[v] = state >> 8;
+					}
+
+					spec.center = { (int)(values[0] % width), (int)(values[1] % height) };
+					spec.radius = 5 + (int)(values[2] % 20);
+					spec.vertices_number = 3 + (int)(values[3] % 8);
+					spec.angle = 2 * Window::pi * (values[2] >> 5 & 1023) / 1024;
+
+					return true;
+				}, command.count > 0 ? command.count : 0);
+				break;
+			}
+
+			case Window::COMMAND_ROTATE:
+				scene.rotateActiveFigure(command.angle);
+				break;
+
+			case Window::COMMAND_ROTATE_ALL:
+				scene.rotateAllFigures(command.angle);
+				break;
+
+			case Window::COMMAND_ROTATE_AROUND_SELECTED:
+				scene.rotateActiveFigureAroundSelected(command.angle);
+				break;
+
+			case Window::COMMAND_ROTATE_AROUND_POINT:
+				scene.rotateActiveFigureAroundPoint(command.point, command.angle);
+				break;
+
+			case Window::COMMAND_MOVE:
+				scene.moveActiveFigureTo(command.point);
+				break;
+
+			case Window::COMMAND_MOVE_TO_SELECTED:
+				scene.moveActiveFigureToSelected();
+				break;
+
+			case Window::COMMAND_NEXT:
+				scene.setNextFigureAsActive();
+				break;
+
+			case Window::COMMAND_PREV:
+				scene.setPrevFigureAsActive();
+				break;
+
+			case Window::COMMAND_GROW:
+				scene.increaseActiveFigureRadius();
+				break;
+
+			case Window::COMMAND_SHRINK:
+				scene.decreaseActiveFigureRadius();
+				break;
+
+			case Window::COMMAND_SELECT:
+				scene.selectActiveFigure();
+				break;
+
+			// Lock mode is toggled, locked scene highlights the largest figure of every kind
+			case Window::COMMAND_LOCK:
+				if (scene.isBlocked()) {
+					scene.unlockScene();
+					scene.restoreAfterBlocking();
+				} else {
+					scene.lockScene();
+					scene.setAllLargestFigureAsActive();
+				}
+				break;
+
+			case Window::COMMAND_DELETE:
+				scene.deleteActiveFigure();
+				break;
+
+			case Window::COMMAND_DELETE_ALL:
+				scene.deleteAllFigures();
+				break;
+
+			case Window::COMMAND_ATTACH:
+				scene.attachActiveFigureToSelected();
+				break;
+
+			case Window::COMMAND_DETACH:
+				scene.detachActiveFigure();
+				break;
+
+			// Place is the move of clicks, it snaps to the nearest center or vertex in snap modes
+			case Window::COMMAND_PLACE:
+				scene.moveActiveFigureNear(command.point);
+				break;
+
+			case Window::COMMAND_SNAP:
+				scene.setNextSnapMode();
+				break;
+
+			default:
+				throw std::runtime_error("[ERR] Window::applyCommand: unknown command");
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,321 @@
+/*!
+	\file
+	\brief Headless driver of the scene for load tests and capacity planning
+	\details Reads a script of scene commands (see Window::parseCommand) from the file
+		or stdin, applies it as fast as possible and prints throughput of every command.
+		Frames may be rendered to the software framebuffer after every N commands.
+		With --memory the tracked memory is reported by subsystem, with the number of
+		frames that made tracked allocations, which is zero when the tracked containers
+		of rendering are reused. Plain std containers are not counted.
+		With --stream changes are flushed to viewers (viewer.cpp) after every command,
+		--viewers waits for N viewers before the script starts. With --layered frames are
+		rendered from published snapshots with the cached background layer, like WM_PAINT.
+
+		driver [--render N] [--size WIDTHxHEIGHT] [--repeat N] [--layered] [--memory]
+			[--stream SOCKET [--viewers N]] [script]
+
+		Build without the window: g++ -std=c++17 -O2 -pthread driver.cpp -o driver
+	\author Crinax
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "scene.h"
+#include "raster.h"
+#include "layer.h"
+#include "commands.h"
+#include "stream.h"
+
+// Errors printed before the driver goes quiet
+const int MAX_PRINTED_ERRORS = 10;
+
+// Time and outcome of commands of one type
+struct CommandStats {
+	long long count;
+	long long errors;
+	double total_ns;
+	double max_ns;
+};
+
+// Script command with the line it came from
+struct ScriptLine {
+	Window::SceneCommand command;
+	int line;
+};
+
+double elapsedNs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+	return std::chrono::duration<double, std::nano>(to - from).count();
+}
+
+/*!
+	\brief Draw every figure of the scene like WM_PAINT does
+	\param [in] scene {The scene}
+	\param [in] frame {The framebuffer}
+	\param [in] states {Buffer for states of figures}
+*/
+void renderFrame(Window::Scene& scene, Window::Framebuffer& frame, Window::FigureStates& states) {
+	int element_count = scene.countElements();
+
+	scene.getFigureStates(0, element_count, states);
+	frame.clear(Window::background_color);
+
+	for (int i = 0; i < element_count; i++) {
+		Window::Figure figure = scene.getFigure(i);
+
+		frame.drawFigure(figure, Window::getFigurePen(
+			(states[i] & Window::Scene::FIGURE_ACTIVE) != 0,
+			(states[i] & Window::Scene::FIGURE_SELECTED) != 0
+		));
+	}
+}
+
+int main(int argc, char** argv) {
+	int render_every = 0;
+	int width = 640;
+	int height = 480;
+	int repeat = 1;
+	bool is_layered = false;
+	bool is_memory_tracked = false;
+	const char* stream_path = NULL;
+	int viewer_count = 0;
+	const char* path = NULL;
+
+	for (int a = 1; a < argc; a++) {
+		if (strcmp(argv[a], "--render") == 0 && a + 1 < argc) {
+			render_every = atoi(argv[++a]);
+		} else if (strcmp(argv[a], "--size") == 0 && a + 1 < argc) {
+			if (sscanf(argv[++a], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+				fprintf(stderr, "wrong frame size: %s\n", argv[a]);
+				return 2;
+			}
+		} else if (strcmp(argv[a], "--repeat") == 0 && a + 1 < argc) {
+			repeat = atoi(argv[++a]);
+		} else if (strcmp(argv[a], "--layered") == 0) {
+			is_layered = true;
+		} else if (strcmp(argv[a], "--memory") == 0) {
+			is_memory_tracked = true;
+		} else if (strcmp(argv[a], "--stream") == 0 && a + 1 < argc) {
+			stream_path = argv[++a];
+		} else if (strcmp(argv[a], "--viewers") == 0 && a + 1 < argc) {
+			viewer_count = atoi(argv[++a]);
+		} else if (argv[a][0] == '-' && argv[a][1] != '\0') {
+			fprintf(stderr, "usage: %s [--render N] [--size WIDTHxHEIGHT] [--repeat N] [--layered] [--memory] [--stream SOCKET [--viewers N]] [script]\n", argv[0]);
+			return 2;
+		} else {
+			path = argv[a];
+		}
+	}
+
+	FILE* input = path && strcmp(path, "-") != 0 ? fopen(path, "r") : stdin;
+
+	if (input == NULL) {
+		fprintf(stderr, "can't open %s\n", path);
+		return 2;
+	}
+
+	// Whole script is parsed first, so the timing covers only the scene
+	std::vector<ScriptLine> script;
+	char text[1024];
+	int line = 0;
+
+	while (fgets(text, sizeof(text), input)) {
+		Window::SceneCommand command;
+
+		line++;
+
+		try {
+			if (Window::parseCommand(text, command)) {
+				script.push_back({ command, line });
+			}
+		} catch (const std::exception& err) {
+			fprintf(stderr, "line %d: %s\n", line, err.what());
+			return 1;
+		}
+	}
+
+	if (input != stdin) {
+		fclose(input);
+	}
+
+	// Tracking starts before the scene, so its whole memory is counted
+	if (is_memory_tracked) {
+		Window::MemoryTelemetry::getShared().enable();
+	}
+
+	Window::Scene scene;
+	Window::Framebuffer frame(width, height);
+	Window::FigureStates states;
+	std::unique_ptr<Window::StreamServer> stream;
+	std::unique_ptr<Window::SnapshotPublisher> snapshots;
+	Window::LayerRenderer layers;
+	int reader_slot = 0;
+	CommandStats stats[Window::COMMAND_COUNT] = {};
+	long long applied = 0;
+	long long errors = 0;
+	long long frames = 0;
+	double commands_ns = 0;
+	double frames_ns = 0;
+	double max_frame_ns = 0;
+
+	if (stream_path != NULL) {
+		try {
+			stream.reset(new Window::StreamServer(scene, stream_path));
+		} catch (const std::exception& err) {
+			fprintf(stderr, "%s\n", err.what());
+			return 2;
+		}
+
+		while (stream->countViewers() < viewer_count) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			stream->flush();
+		}
+	}
+
+	if (is_layered) {
+		snapshots.reset(new Window::SnapshotPublisher(scene));
+		reader_slot = snapshots->registerReader();
+	}
+
+	std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+	for (int r = 0; r < repeat; r++) {
+		for (size_t s = 0; s < script.size(); s++) {
+			CommandStats& command_stats = stats[script[s].command.type];
+			std::chrono::steady_clock::time_point before = std::chrono::steady_clock::now();
+
+			try {
+				Window::applyCommand(scene, script[s].command);
+			} catch (const std::exception& err) {
+				if (errors < MAX_PRINTED_ERRORS) {
+					fprintf(stderr, "line %d: %s\n", script[s].line, err.what());
+				}
+
+				command_stats.errors++;
+				errors++;
+			}
+
+			if (stream) {
+				stream->flush();
+			}
+
+			double spent = elapsedNs(before, std::chrono::steady_clock::now());
+
+			command_stats.count++;
+			command_stats.total_ns += spent;
+			command_stats.max_ns = spent > command_stats.max_ns ? spent : command_stats.max_ns;
+			commands_ns += spent;
+			applied++;
+
+			if (render_every > 0 && applied % render_every == 0) {
+				before = std::chrono::steady_clock::now();
+
+				// Publishing belongs to the edits, as in the window, it is outside the frame
+				if (snapshots) {
+					snapshots->publish();
+				}
+
+				Window::MemoryTelemetry::getShared().beginFrame();
+
+				if (snapshots) {
+					Window::SnapshotGuard snapshot(*snapshots, reader_slot);
+
+					layers.render(*snapshot, frame);
+				} else {
+					renderFrame(scene, frame, states);
+				}
+
+				Window::MemoryTelemetry::getShared().endFrame();
+				spent = elapsedNs(before, std::chrono::steady_clock::now());
+
+				frames++;
+				frames_ns += spent;
+				max_frame_ns = spent > max_frame_ns ? spent : max_frame_ns;
+			}
+		}
+	}
+
+	double total_ns = elapsedNs(started, std::chrono::steady_clock::now());
+
+	printf("figures at the end: %d\n", scene.countElements());
+	printf(
+		"commands: %lld in %.1f ms, %.0f commands/s, %lld errors\n",
+		applied,
+		commands_ns / 1e6,
+		commands_ns > 0 ? applied * 1e9 / commands_ns : 0.0,
+		errors
+	);
+	printf("%-18s %10s %8s %12s %10s %10s\n", "command", "count", "errors", "total ms", "avg us", "max us");
+
+	for (int type = 0; type < Window::COMMAND_COUNT; type++) {
+		if (stats[type].count == 0) {
+			continue;
+		}
+
+		printf(
+			"%-18s %10lld %8lld %12.2f %10.2f %10.2f\n",
+			Window::command_names[type],
+			stats[type].count,
+			stats[type].errors,
+			stats[type].total_ns / 1e6,
+			stats[type].total_ns / stats[type].count / 1e3,
+			stats[type].max_ns / 1e3
+		);
+	}
+
+	if (frames > 0) {
+		printf(
+			"frames: %lld of %dx%d in %.1f ms, avg %.2f ms, max %.2f ms\n",
+			frames,
+			width,
+			height,
+			frames_ns / 1e6,
+			frames_ns / frames / 1e6,
+			max_frame_ns / 1e6
+		);
+	}
+
+	Window::ArenaStats memory = scene.getFigureMemory();
+
+	printf(
+		"figure memory: %.1f MB used, %.1f MB retained, %.1f MB peak\n",
+		memory.used / 1048576.0,
+		memory.retained / 1048576.0,
+		memory.peak / 1048576.0
+	);
+	printf("wall time: %.1f ms\n", total_ns / 1e6);
+
+	if (stream) {
+		// Viewers get the rest of the stream, unless they are too slow to take it in a few seconds
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+		stream->flush();
+
+		while (stream->countQueuedBytes() > 0 && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			stream->flush();
+		}
+
+		Window::StreamStats stream_stats = stream->getStats();
+
+		printf(
+			"stream: %lld messages, %lld keyframes, %.1f KB encoded, %.1f KB sent, %lld resyncs, %d viewers\n",
+			stream_stats.messages,
+			stream_stats.keyframes,
+			stream_stats.bytes_encoded / 1024.0,
+			stream_stats.bytes_sent / 1024.0,
+			stream_stats.resyncs,
+			stream->countViewers()
+		);
+	}
+
+	if (is_memory_tracked) {
+		Window::MemoryTelemetry::getShared().printReport(stdout);
+	}
+
+	return 0;
+}
@@ -0,0 +1,595 @@
+#ifndef PAINTING_EXPORT_H
+#define PAINTING_EXPORT_H
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <vector>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "scene.h"
+#include "raster.h"
+
+namespace Window {
+	/*!
+		\brief Open file for the exporters, the file is created or truncated
+		\param [in] path {Path of the file}
+	*/
+	inline int openExportFile(const char* path) {
+#ifdef _WIN32
+		int fd = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+		int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+
+		if (fd < 0) {
+			throw std::runtime_error("[ERR] Window::Export: can't open file for export");
+		}
+
+		return fd;
+	}
+
+	// Close file opened by openExportFile
+	inline void closeExportFile(int fd) {
+#ifdef _WIN32
+		_close(fd);
+#else
+		close(fd);
+#endif
+	}
+
+	/*!
+		\brief Buffered writer to a file descriptor
+		\details The descriptor is owned by the caller. Memory use is the fixed buffer.
+		\version 1.0.0
+		\author Crinax
+	*/
+	class FileWriter {
+		public:
+			static const size_t BUFFER_SIZE = 64 * 1024;
+
+			/*!
+				\brief Main constructor for class
+				\param [in] fd {File descriptor opened for writing}
+			*/
+			FileWriter(int fd) {
+				this->fd = fd;
+				this->used = 0;
+				this->buffer.resize(Window::FileWriter::BUFFER_SIZE);
+			}
+
+			~FileWriter() {
+				// Destructor must not throw, call flush() to see write errors
+				try {
+					this->flush();
+				} catch (...) {
+				}
+			}
+
+			/*!
+				\brief Write bytes through the buffer
+				\param [in] data {Bytes to write}
+				\param [in] size {Number of bytes}
+			*/
+			void write(const void* data, size_t size) {
+				const char* bytes = (const char*)data;
+
+				while (size > 0) {
+					if (this->used == this->buffer.size()) {
+						this->flush();
+					}
+
+					size_t part = std::min(size, this->buffer.size() - this->used);
+
+					std::copy(bytes, bytes + part, this->buffer.begin() + this->used);
+					this->used += part;
+					bytes += part;
+					size -= part;
+				}
+			}
+
+			// Write null-terminated string
+			void put(const char* text) {
+				size_t size = 0;
+
+				while (text[size] != '\0') {
+					size++;
+				}
+
+				this->write(text, size);
+			}
+
+			// Pass the buffered bytes to the descriptor
+			void flush() {
+				size_t written = 0;
+
+				while (written < this->used) {
+#ifdef _WIN32
+					int result = _write(this->fd, this->buffer.data() + written, (unsigned int)(this->used - written));
+#else
+					ssize_t result = ::write(this->fd, this->buffer.data() + written, this->used - written);
+#endif
+
+					if (result < 0 && errno == EINTR) {
+						continue;
+					}
+
+					if (result <= 0) {
+						this->used = 0;
+						throw std::runtime_error("[ERR] Window::FileWriter: write failed");
+					}
+
+					written += result;
+				}
+
+				this->used = 0;
+			}
+
+		protected:
+			int fd;
+			size_t used;
+			Window::TrackedVector<char, Window::MEMORY_EXPORT> buffer;
+	};
+
+	/*!
+		\brief Writes the scene as SVG, one polygon per figure
+		\details Figures are written while the scene is walked, nothing is collected in memory.
+		\version 1.0.0
+		\author Crinax
+	*/
+	class SvgExporter {
+		public:
+			/*!
+				\brief Main constructor for class
+				\param [in] fd {File descriptor opened for writing}
+			*/
+			SvgExporter(int fd) : writer(fd) {}
+
+			/*!
+				\brief Write the scene
+				\param [in] scene {The scene}
+				\param [in] width {Width of the picture}
+				\param [in] height {Height of the picture}
+			*/
+			void exportScene(Window::Scene& scene, int width, int height) {
+				char text[128];
+
+				snprintf(
+					text,
+					sizeof(text),
+					"<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n",
+					width,
+					height,
+					width,
+					height
+				);
+				this->writer.put(text);
+				this->writer.put("<rect width=\"100%\" height=\"100%\" fill=\"#ffffff\"/>\n");
+
+				int element_count = scene.countElements();
+
+				for (int i = 0; i < element_count; i++) {
+					Window::Figure figure = scene.getFigure(i);
+
+					if (!figure.is_initialized) {
+						continue;
+					}
+
+					unsigned char state = scene.getFigureState(i);
+					Window::Pen pen = Window::getFigurePen(
+						(state & Window::Scene::FIGURE_ACTIVE) != 0,
+						(state & Window::Scene::FIGURE_SELECTED) != 0
+					);
+					Window::Point vertices[Window::Figure::MAX_VERTICES];
+					int vertices_count = figure.getVertices(vertices);
+
+					this->writer.put("<polygon points=\"");
+
+					for (int v = 0; v < vertices_count; v++) {
+						snprintf(text, sizeof(text), v == 0 ? "%d,%d" : " %d,%d", vertices[v].x, vertices[v].y);
+						this->writer.put(text);
+					}
+
+					snprintf(
+						text,
+						sizeof(text),
+						"\" fill=\"none\" stroke=\"#%02x%02x%02x\" stroke-width=\"%d\"/>\n",
+						pen.color.r,
+						pen.color.g,
+						pen.color.b,
+						pen.width
+					);
+					this->writer.put(text);
+				}
+
+				this->writer.put("</svg>\n");
+				this->writer.flush();
+			}
+
+		protected:
+			Window::FileWriter writer;
+	};
+
+	/*!
+		\brief Writes the scene as PNG rendered by the software renderer
+		\details The picture is rendered in strips of tile_height rows. Every strip is
+			filtered, deflated with fixed Huffman codes and written as one IDAT chunk
+			before the next strip is rendered, so memory depends on the strip only. Indexes
+			of figures crossing a window of strips are collected by one pass over the scene
+			into a buffer of at most WINDOW_FIGURES, the window shrinks while they don't fit.
+			A strip which alone has more figures is drawn by a pass over the scene.
+		\version 1.1.1
+		\author Crinax
+	*/
+	class PngExporter {
+		public:
+			// Capacity of the buffer of figures of the current window of strips
+			static const int WINDOW_FIGURES = 1 << 14;
+
+			/*!
+				\brief Main constructor for class
+				\param [in] fd {File descriptor opened for writing}
+				\param [in] tile_height {Rows rendered at once}
+			*/
+			PngExporter(int fd, int tile_height = 64) : writer(fd), tile(0, 0) {
+				this->tile_height = std::max(tile_height, 1);
+				this->bits = 0;
+				this->bit_count = 0;
+				this->adler_a = 1;
+				this->adler_b = 0;
+			}
+
+			/*!
+				\brief Write the scene
+				\param [in] scene {The scene}
+				\param [in] width {Width of the picture}
+				\param [in] height {Height of the picture}
+			*/
+			void exportScene(Window::Scene& scene, int width, int height) {
+				if (width < 1 || height < 1) {
+					throw std::out_of_range("[ERR] Window::PngExporter: picture is empty");
+				}
+
+				static const unsigned char signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+				this->writer.write(signature, sizeof(signature));
+
+				unsigned char header[13] = {};
+				this->putBigEndian(header, width);
+				this->putBigEndian(header + 4, height);
+				header[8] = 8;
+				header[9] = 2;
+				this->writeChunk("IHDR", header, sizeof(header));
+
+				this->bits = 0;
+				this->bit_count = 0;
+				this->adler_a = 1;
+				this->adler_b = 0;
+				this->output.clear();
+
+				// zlib header: deflate with 32K window, no dictionary
+				this->output.push_back(0x78);
+				this->output.push_back(0x01);
+
+				int strip_count = (height + this->tile_height - 1) / this->tile_height;
+				int window_strips = strip_count;
+
+				for (int strip = 0; strip < strip_count;) {
+					int end = std::min(strip_count, strip + window_strips);
+					bool is_collected = this->collectFigures(scene, height, strip, end - 1);
+
+					if (!is_collected && window_strips > 1) {
+						window_strips = (window_strips + 1) / 2;
+						continue;
+					}
+
+					for (; strip < end; strip++) {
+						this->renderStrip(scene, width, height, strip, is_collected);
+					}
+
+					// Sparse parts of the picture take wider windows again
+					if (is_collected && this->window_figures.size() < (size_t)Window::PngExporter::WINDOW_FIGURES / 4) {
+						window_strips = std::min(strip_count, window_strips * 2);
+					}
+				}
+
+				this->writeChunk("IEND", NULL, 0);
+				this->writer.flush();
+			}
+
+		protected:
+			Window::FileWriter writer;
+			Window::Framebuffer tile;
+			int tile_height;
+			Window::TrackedVector<unsigned char, Window::MEMORY_EXPORT> row;
+			Window::TrackedVector<unsigned char, Window::MEMORY_EXPORT> output;
+			// Indexes of figures crossing the current window of strips, in scene order
+			Window::TrackedVector<int, Window::MEMORY_EXPORT> window_figures;
+			unsigned int bits;
+			int bit_count;
+			unsigned int adler_a;
+			unsigned int adler_b;
+
+			/*!
+				\brief Collect figures crossing strips [first_strip, last_strip] into window_figures
+				\return False if they don't fit into WINDOW_FIGURES
+			*/
+			bool collectFigures(Window::Scene& scene, int height, int first_strip, int last_strip) {
+				int element_count = scene.countElements();
+				int first;
+				int last;
+
+				this->window_figures.clear();
+
+				for (int i = 0; i < element_count; i++) {
+					Window::Figure figure = scene.getFigure(i);
+
+					if (!this->getStripRange(figure, height, first, last) || last < first_strip || first > last_strip) {
+						continue;
+					}
+
+					if (this->window_figures.size() == (size_t)Window::PngExporter::WINDOW_FIGURES) {
+						return false;
+					}
+
+					this->window_figures.push_back(i);
+				}
+
+				return true;
+			}
+
+			/*!
+				\brief Draw the strip and write it as an IDAT chunk
+				\param [in] is_collected {Figures of the strip are in window_figures, otherwise the whole scene is drawn}
+			*/
+			void renderStrip(Window::Scene& scene, int width, int height, int strip, bool is_collected) {
+				int top = strip * this->tile_height;
+				int rows = std::min(this->tile_height, height - top);
+				int count = is_collected ? (int)this->window_figures.size() : scene.countElements();
+				int first;
+				int last;
+
+				this->tile.resize(width, rows);
+				this->tile.setOrigin({ 0, top });
+				this->tile.clear(Window::background_color);
+
+				for (int f = 0; f < count; f++) {
+					int i = is_collected ? this->window_figures[f] : f;
+					Window::Figure figure = scene.getFigure(i);
+
+					if (!this->getStripRange(figure, height, first, last) || strip < first || strip > last) {
+						continue;
+					}
+
+					unsigned char state = scene.getFigureState(i);
+
+					this->tile.drawFigure(figure, Window::getFigurePen(
+						(state & Window::Scene::FIGURE_ACTIVE) != 0,
+						(state & Window::Scene::FIGURE_SELECTED) != 0
+					));
+				}
+
+				this->encodeTile(top + rows == height);
+				this->writeChunk("IDAT", this->output.data(), this->output.size());
+				this->output.clear();
+			}
+
+			/*!
+				\brief Find strips the figure and the widest pen may touch
+				\details The reach matches the margin of clipFigure, so no drawn figure is missed
+				\return False if the figure is above or below the picture
+			*/
+			bool getStripRange(Window::Figure& figure, int height, int& first, int& last) {
+				if (!figure.is_initialized) {
+					return false;
+				}
+
+				int margin = Window::getFigurePen(true, false).width / 2 + 1;
+				double reach = fabs((double)figure.getRadius()) + Window::CLIP_ROUNDING + margin;
+				double top = figure.getPosition().y - reach;
+				double bottom = figure.getPosition().y + reach;
+
+				if (bottom < 0 || top > height - 1) {
+					return false;
+				}
+
+				first = (int)(std::max(top, 0.0) / this->tile_height);
+				last = (int)(std::min(bottom, height - 1.0) / this->tile_height);
+
+				return true;
+			}
+
+			void putBigEndian(unsigned char* target, unsigned int value) {
+				target[0] = (unsigned char)(value >> 24);
+				target[1] = (unsigned char)(value >> 16);
+				target[2] = (unsigned char)(value >> 8);
+				target[3] = (unsigned char)value;
+			}
+
+			unsigned int updateCrc(unsigned int crc, const unsigned char* data, size_t size) {
+				static unsigned int table[256];
+				static bool has_table = false;
+
+				if (!has_table) {
+					for (unsigned int n = 0; n < 256; n++) {
+						unsigned int c = n;
+
+						for (int k = 0; k < 8; k++) {
+							c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+						}
+
+						table[n] = c;
+					}
+
+					has_table = true;
+				}
+
+				for (size_t i = 0; i < size; i++) {
+					crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+				}
+
+				return crc;
+			}
+
+			void writeChunk(const char* type, const unsigned char* data, size_t size) {
+				unsigned char length[4];
+				unsigned char crc_bytes[4];
+
+				this->putBigEndian(length, (unsigned int)size);
+				this->writer.write(length, 4);
+				this->writer.write(type, 4);
+
+				if (size > 0) {
+					this->writer.write(data, size);
+				}
+
+				unsigned int crc = this->updateCrc(0xFFFFFFFFu, (const unsigned char*)type, 4);
+				crc = this->updateCrc(crc, data, size);
+				this->putBigEndian(crc_bytes, crc ^ 0xFFFFFFFFu);
+				this->writer.write(crc_bytes, 4);
+			}
+
+			// Append bits to the deflate stream, least significant first
+			void putBits(unsigned int value, int count) {
+				this->bits |= value << this->bit_count;
+				this->bit_count += count;
+
+				while (this->bit_count >= 8) {
+					this->output.push_back((unsigned char)this->bits);
+					this->bits >>= 8;
+					this->bit_count -= 8;
+				}
+			}
+
+			// Append Huffman code, codes are stored most significant bit first
+			void putCode(unsigned int code, int length) {
+				unsigned int reversed = 0;
+
+				for (int i = 0; i < length; i++) {
+					reversed = (reversed << 1) | ((code >> i) & 1);
+				}
+
+				this->putBits(reversed, length);
+			}
+
+			// Fixed Huffman code of literal or length symbol
+			void putSymbol(int symbol) {
+				if (symbol < 144) {
+					this->putCode(0x30 + symbol, 8);
+				} else if (symbol < 256) {
+					this->putCode(0x190 + symbol - 144, 9);
+				} else if (symbol < 280) {
+					this->putCode(symbol - 256, 7);
+				} else {
+					this->putCode(0xC0 + symbol - 280, 8);
+				}
+			}
+
+			// Copy of the previous byte repeated length times (3..258)
+			void putRepeat(int length) {
+				static const int base[29] = {
+					3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+					35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+				};
+				static const int extra[29] = {
+					0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+					3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+				};
+
+				int code = 28;
+
+				while (base[code] > length) {
+					code--;
+				}
+
+				this->putSymbol(257 + code);
+				this->putBits(length - base[code], extra[code]);
+
+				// Distance 1 is code 0 of the fixed distance codes
+				this->putCode(0, 5);
+			}
+
+			// Deflate the rendered tile as one fixed Huffman block
+			void encodeTile(bool is_last) {
+				int width = this->tile.getWidth();
+				size_t stride = (size_t)width * 3;
+
+				this->row.resize(stride + 1);
+				this->putBits(is_last ? 1 : 0, 1);
+				this->putBits(1, 2);
+
+				for (int y = 0; y < this->tile.getHeight(); y++) {
+					unsigned char* pixels = this->tile.getRow(y);
+
+					// Sub filter turns runs of one color into runs of zeros
+					this->row[0] = 1;
+
+					for (size_t i = 0; i < stride; i++) {
+						this->row[i + 1] = (unsigned char)(pixels[i] - (i >= 3 ? pixels[i - 3] : 0));
+					}
+
+					this->updateAdler(this->row.data(), this->row.size());
+
+					size_t i = 0;
+
+					while (i < this->row.size()) {
+						unsigned char value = this->row[i];
+						size_t run = 1;
+
+						while (i + run < this->row.size() && this->row[i + run] == value) {
+							run++;
+						}
+
+						this->putSymbol(value);
+
+						size_t left = run - 1;
+
+						while (left >= 3) {
+							int length = (int)std::min(left, (size_t)258);
+
+							// Leave at least 3 bytes for the last copy
+							if (left - length > 0 && left - length < 3) {
+								length -= 3;
+							}
+
+							this->putRepeat(length);
+							left -= length;
+						}
+
+						for (; left > 0; left--) {
+							this->putSymbol(value);
+						}
+
+						i += run;
+					}
+				}
+
+				this->putSymbol(256);
+
+				if (is_last) {
+					if (this->bit_count > 0) {
+						this->putBits(0, 8 - this->bit_count);
+					}
+
+					unsigned char adler[4];
+					this->putBigEndian(adler, (this->adler_b << 16) | this->adler_a);
+					this->output.insert(this->output.end(), adler, adler + 4);
+				}
+			}
+
+			void updateAdler(const unsigned char* data, size_t size) {
+				for (size_t i = 0; i < size; i++) {
+					this->adler_a = (this->adler_a + data[i]) % 65521;
+					this->adler_b = (this->adler_b + this->adler_a) % 65521;
+				}
+			}
+	};
+};
+
+#endif
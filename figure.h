@@ -0,0 +1,364 @@
+#ifndef PAINTING_FIGURE_H
+#define PAINTING_FIGURE_H
+
+#include <math.h>
+#include <stddef.h>
+#include <array>
+#include <utility>
+#include <stdexcept>
+
+#include "telemetry.h"
+
+/*!
+	\brief Define namespace to avoid names conflict
+	\version 1.0.0
+	\date 10.04.2022
+	\author Crinax
+*/
+namespace Window {
+	/*!
+		\brief Structure for dots with coords x and y
+		\version 1.0.0
+		\date 10.04.2022
+		\author Crinax
+	*/
+	struct Point {
+		int x;
+		int y;
+	};
+
+	// Определяем константы
+	constexpr double pi = 3.14;
+	constexpr double rotate_angle = pi / 12;
+
+	// Sine for compile-time tables, Taylor series after reduction to [-pi, pi]
+	constexpr double constexprSin(double x) {
+		const double two_pi = 6.283185307179586476925286766559;
+		long long turns = (long long)(x / two_pi + (x >= 0 ? 0.5 : -0.5));
+
+		x -= turns * two_pi;
+
+		double term = x;
+		double sum = x;
+
+		for (int k = 1; k < 16; k++) {
+			term *= -x * x / ((2 * k) * (2 * k + 1));
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	constexpr double constexprCos(double x) {
+		return Window::constexprSin(x + 1.5707963267948966192313216916398);
+	}
+
+	/*!
+		\brief Vertices of the figure with N vertices for center (0, 0), radius 1 and angle 0
+		\details Angles are 2 * pi * i / N with pi of this namespace, as in FigureTemplate
+	*/
+	template <int N>
+	struct UnitPolygon {
+		std::array<double, N> cosines;
+		std::array<double, N> sines;
+
+		constexpr UnitPolygon() : cosines(), sines() {
+			for (int i = 0; i < N; i++) {
+				this->cosines[i] = Window::constexprCos(2 * Window::pi * i / N);
+				this->sines[i] = Window::constexprSin(2 * Window::pi * i / N);
+			}
+		}
+	};
+
+	/*!
+		\brief Figure kind with N vertices known at compile time
+		\details Vertices are the unit polygon rotated and scaled by one pair of sin/cos,
+			the loop over vertices is unrolled.
+		\version 1.1.0
+		\author Crinax
+	*/
+	template <int N>
+	struct FigureKind {
+		static constexpr Window::UnitPolygon<N> unit = Window::UnitPolygon<N>();
+
+		/*!
+			\brief Compute vertices of the figure
+			\param [in] center {Coords of center of the figure}
+			\param [in] c {Radius times cosine of the angle of the figure}
+			\param [in] s {Radius times sine of the angle of the figure}
+			\param [out] vertex {N vertices}
+		*/
+		static void getVertices(Window::Point center, double c, double s, Window::Point* vertex) {
+			Window::FigureKind<N>::transform(center, c, s, vertex, std::make_integer_sequence<int, N>());
+		}
+
+		template <int... I>
+		static void transform(Window::Point center, double c, double s, Window::Point* vertex, std::integer_sequence<int, I...>) {
+			((vertex[I] = {
+				(int)(center.x + (c * unit.cosines[I] - s * unit.sines[I])),
+				(int)(center.y + (s * unit.cosines[I] + c * unit.sines[I])),
+			}), ...);
+		}
+	};
+
+	/*!
+		\brief Unit geometry of figures with the same number of vertices
+		\details Immutable after construction and shared by all figures of the kind, in
+			all scenes, see TemplateLibrary. Kinds with FigureKind take its tables.
+		\version 1.0.0
+		\author Crinax
+	*/
+	struct FigureTemplate {
+		static const int MAX_VERTICES = 10;
+
+		int vertices_number;
+		double cosines[Window::FigureTemplate::MAX_VERTICES];
+		double sines[Window::FigureTemplate::MAX_VERTICES];
+
+		/*!
+			\brief Main constructor for class
+			\param [in] vertices_number {Number of vertices (MAX_VERTICES=10)}
+		*/
+		FigureTemplate(int vertices_number) {
+			if (vertices_number > Window::FigureTemplate::MAX_VERTICES) {
+				throw std::out_of_range("Window::Figure: Too many vertices");
+			}
+
+			if (vertices_number < 0) {
+				throw std::out_of_range("Window::Figure: Negative number of vertices");
+			}
+
+			this->vertices_number = vertices_number;
+
+			for (int i = 0; i < vertices_number; i++) {
+				switch (vertices_number) {
+					case 3:
+						this->cosines[i] = Window::FigureKind<3>::unit.cosines[i];
+						this->sines[i] = Window::FigureKind<3>::unit.sines[i];
+						break;
+
+					case 4:
+						this->cosines[i] = Window::FigureKind<4>::unit.cosines[i];
+						this->sines[i] = Window::FigureKind<4>::unit.sines[i];
+						break;
+
+					case 6:
+						this->cosines[i] = Window::FigureKind<6>::unit.cosines[i];
+						this->sines[i] = Window::FigureKind<6>::unit.sines[i];
+						break;
+
+					default:
+						this->cosines[i] = cos(2 * Window::pi * i / vertices_number);
+						this->sines[i] = sin(2 * Window::pi * i / vertices_number);
+				}
+			}
+		}
+
+		// Templates are counted as their own subsystem of the tracked memory
+		static void* operator new(size_t bytes) {
+			return Window::MemoryTelemetry::getShared().allocate(bytes, Window::MEMORY_TEMPLATES);
+		}
+
+		static void operator delete(void* memory, size_t bytes) {
+			Window::MemoryTelemetry::getShared().deallocate(memory, bytes, Window::MEMORY_TEMPLATES);
+		}
+	};
+
+	/*!
+		\brief Class for figures
+		\details Active and selected state belongs to the scene, see Scene::getFigureState.
+			A figure is its template and pose, vertices are computed when asked for.
+		\version 2.0.0
+		\date 10.04.2022
+		\author Crinax
+	*/
+	class Figure {
+		public:
+			/*! 
+				\brief Empty constructor to initialization without params.
+				\details If you initialized class with this constructor help, field is_initialized equals false
+			*/
+			Figure() {
+				this->is_initialized = false;
+				this->shape = NULL;
+			}
+
+			/*!
+				\brief Main constructor for class
+				\param [in] shape {Template of the figure, must outlive the figure}
+				\param [in] coords {Coords of center of the figure}
+				\param [in] radius {Radius of circumscribed circle around the figure}
+				\param [in] angle {Angle of rotation of the figure}
+			*/
+			Figure(
+				const Window::FigureTemplate* shape,
+				Window::Point coords,
+				int radius,
+				double angle
+			) {
+				this->shape = shape;
+				this->coords = coords;
+				this->radius = radius;
+				this->angle = angle;
+
+				this->updateTransform();
+
+				this->is_initialized = true;
+			}
+
+			bool is_initialized;
+			static const int MAX_VERTICES = Window::FigureTemplate::MAX_VERTICES;
+			
+			// Returns coors of center of the figure
+			Window::Point getPosition() {
+				return this->coords;
+			}
+
+			// Returns radius of circle
+			int getRadius() {
+				return this->radius;
+			}
+			
+			// Returns angle of rotation of the figure
+			double getAngle() {
+				return this->angle;
+			}
+
+			// Returns template of the figure, NULL for figures made by the empty constructor
+			const Window::FigureTemplate* getTemplate() {
+				return this->shape;
+			}
+
+			/*!
+				\brief Compute vertices of the figure
+				\param [out] vertex {Buffer for MAX_VERTICES vertices}
+				\return Number of vertices
+			*/
+			int getVertices(Window::Point* vertex) {
+				int vertices_number = this->countVertices();
+
+				switch (vertices_number) {
+					case 3:
+						Window::FigureKind<3>::getVertices(this->coords, this->scaled_cos, this->scaled_sin, vertex);
+						return 3;
+
+					case 4:
+						Window::FigureKind<4>::getVertices(this->coords, this->scaled_cos, this->scaled_sin, vertex);
+						return 4;
+
+					case 6:
+						Window::FigureKind<6>::getVertices(this->coords, this->scaled_cos, this->scaled_sin, vertex);
+						return 6;
+				}
+
+				for (int i = 0; i < vertices_number; i++) {
+					vertex[i] = {
+						(int)(this->coords.x + (this->scaled_cos * this->shape->cosines[i] - this->scaled_sin * this->shape->sines[i])),
+						(int)(this->coords.y + (this->scaled_sin * this->shape->cosines[i] + this->scaled_cos * this->shape->sines[i])),
+					};
+				}
+
+				return vertices_number;
+			}
+
+			// Returns number of vertices
+			int countVertices() {
+				return this->shape != NULL ? this->shape->vertices_number : 0;
+			}
+
+			/*!
+				\brief Set circle radius
+				\param [in] radius {New radius of the figure}
+			*/
+			void setRadius(int radius) {
+				this->radius = radius;
+
+				this->updateTransform();
+			}
+
+			/*!
+				\brief Set angle of rotation of the figure
+				\param [in] angle {New angle of rotation}
+			*/
+			void setAngle(double angle) {
+				this->angle = angle;
+
+				this->updateTransform();
+			}
+
+			/*!
+				\brief Set position and angle of the figure
+				\param [in] point {New center of the figure}
+				\param [in] angle {New angle of rotation}
+			*/
+			void setPose(Window::Point point, double angle) {
+				this->coords = point;
+				this->angle = angle;
+
+				this->updateTransform();
+			}
+
+			/*!
+				\brief Scale of the figure
+				\param [in] pixels {How many pixels the figure increases by}
+			*/
+			void scale(int pixels) {
+				this->radius += pixels;
+
+				this->updateTransform();
+			}
+
+			/*!
+				\brief Move figure to point
+				\param [in] point {What point to move the figure to}
+			*/
+			void moveTo(Window::Point point) {
+				this->coords.x = point.x;
+				this->coords.y = point.y;
+			}
+
+			/*!
+				\brief Rotate the figure
+				\param [in] angle {How many radians the figure rotate by}
+			*/
+			void rotate(double angle) {
+				this->angle += angle;
+
+				this->updateTransform();
+			}
+
+			/*!
+				\brief Rotate the figure around point
+				\param [in] point {The point around which the turn will be}
+				\param [in] angle {How many radians the figure rotate by}
+			*/
+			void rotateAround(Window::Point point, double angle) {
+				Window::Point new_coords = {
+					(int)((this->coords.x - point.x) * cos(angle) - (this->coords.y - point.y) * sin(angle) + point.x),
+					(int)((this->coords.x - point.x) * sin(angle) + (this->coords.y - point.y) * cos(angle) + point.y),
+				};
+
+				this->coords = new_coords;
+			}
+
+		protected:
+			// Ordered to pack the figure into 48 bytes
+			int radius;
+			Window::Point coords;
+			const Window::FigureTemplate* shape;
+			double angle;
+			double scaled_cos;
+			double scaled_sin;
+
+			// Scale and rotation of the unit geometry, one sin/cos per change of the pose
+			void updateTransform() {
+				this->scaled_cos = this->radius * cos(this->angle);
+				this->scaled_sin = this->radius * sin(this->angle);
+			}
+	};
+
+	// Figures of the scene in order, the pointers are into its arena
+	typedef Window::TrackedVector<Window::Figure*, Window::MEMORY_SCENE> FigureList;
+};
+
+#endif
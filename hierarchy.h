@@ -0,0 +1,303 @@
+#ifndef PAINTING_HIERARCHY_H
+#define PAINTING_HIERARCHY_H
+
+#include <math.h>
+#include <vector>
+#include <stdexcept>
+
+#include "figure.h"
+
+namespace Window {
+	/*!
+		\brief Position and angle of a figure, relative to the parent or to the window
+		\version 1.0.0
+		\author Crinax
+	*/
+	struct Pose {
+		double x;
+		double y;
+		double angle;
+	};
+
+	/*!
+		\brief Parent links between figures of the scene with cached world poses
+		\details Nodes are indexed like figures of the scene. Every child keeps its pose
+			relative to the parent, the world pose is cached. Changing a figure only marks
+			it dirty, descendants of dirty figures are recomputed by update() once, however
+			many times their ancestors were changed since the last update.
+		\version 1.0.0
+		\author Crinax
+	*/
+	class Hierarchy {
+		public:
+			Hierarchy() {}
+
+			// Reserve storage for count nodes
+			void reserve(size_t count) {
+				this->parent.reserve(count);
+				this->first_child.reserve(count);
+				this->next_sibling.reserve(count);
+				this->prev_sibling.reserve(count);
+				this->local.reserve(count);
+				this->world.reserve(count);
+				this->is_dirty.reserve(count);
+			}
+
+			/*!
+				\brief Add root node for the figure appended to the scene
+				\param [in] figure {The new figure}
+			*/
+			void insert(Window::Figure& figure) {
+				this->parent.push_back(-1);
+				this->first_child.push_back(-1);
+				this->next_sibling.push_back(-1);
+				this->prev_sibling.push_back(-1);
+				this->local.push_back({ 0, 0, 0 });
+				this->world.push_back(this->poseOf(figure));
+				this->is_dirty.push_back(false);
+			}
+
+			/*!
+				\brief Remove node of the erased figure, its children become roots
+				\param [in] index {Index of the figure}
+			*/
+			void erase(int index) {
+				int child = this->first_child[index];
+
+				while (child != -1) {
+					int next = this->next_sibling[child];
+
+					this->unlink(child);
+					child = next;
+				}
+
+				this->unlink(index);
+
+				this->parent.erase(this->parent.begin() + index);
+				this->first_child.erase(this->first_child.begin() + index);
+				this->next_sibling.erase(this->next_sibling.begin() + index);
+				this->prev_sibling.erase(this->prev_sibling.begin() + index);
+				this->local.erase(this->local.begin() + index);
+				this->world.erase(this->world.begin() + index);
+				this->is_dirty.erase(this->is_dirty.begin() + index);
+
+				Window::TrackedVector<int, Window::MEMORY_HIERARCHY>* links[4] = { &this->parent, &this->first_child, &this->next_sibling, &this->prev_sibling };
+
+				for (int l = 0; l < 4; l++) {
+					Window::TrackedVector<int, Window::MEMORY_HIERARCHY>& link = *links[l];
+
+					for (size_t i = 0; i < link.size(); i++) {
+						if (link[i] > index) {
+							link[i]--;
+						}
+					}
+				}
+
+				size_t kept = 0;
+
+				for (size_t i = 0; i < this->dirty.size(); i++) {
+					if (this->dirty[i] != index) {
+						this->dirty[kept++] = this->dirty[i] > index ? this->dirty[i] - 1 : this->dirty[i];
+					}
+				}
+
+				this->dirty.resize(kept);
+			}
+
+			// Remove all nodes
+			void clear() {
+				this->parent.clear();
+				this->first_child.clear();
+				this->next_sibling.clear();
+				this->prev_sibling.clear();
+				this->local.clear();
+				this->world.clear();
+				this->is_dirty.clear();
+				this->dirty.clear();
+			}
+
+			/*!
+				\brief Make the figure child of another one, keeping its place in the window
+				\param [in] child {Index of the child figure}
+				\param [in] parent {Index of the parent figure}
+			*/
+			void attach(int child, int parent) {
+				for (int node = parent; node != -1; node = this->parent[node]) {
+					if (node == child) {
+						throw std::runtime_error("[ERR] Window::Hierarchy: figure can't be attached to its descendant");
+					}
+				}
+
+				this->unlink(child);
+
+				this->parent[child] = parent;
+				this->next_sibling[child] = this->first_child[parent];
+				this->prev_sibling[child] = -1;
+
+				if (this->first_child[parent] != -1) {
+					this->prev_sibling[this->first_child[parent]] = child;
+				}
+
+				this->first_child[parent] = child;
+				this->local[child] = this->toLocal(this->world[parent], this->world[child]);
+			}
+
+			/*!
+				\brief Make the figure root, keeping its place in the window
+				\param [in] child {Index of the figure}
+			*/
+			void detach(int child) {
+				this->unlink(child);
+			}
+
+			// Returns index of the parent figure or -1
+			int getParent(int index) {
+				return this->parent[index];
+			}
+
+			// Returns true if some ancestor was changed after the last update
+			bool hasDirtyAncestor(int index) {
+				for (int node = this->parent[index]; node != -1; node = this->parent[node]) {
+					if (this->is_dirty[node]) {
+						return true;
+					}
+				}
+
+				return false;
+			}
+
+			// Returns true if update() has work to do
+			bool isDirty() {
+				return !this->dirty.empty();
+			}
+
+			/*!
+				\brief Take new world pose of the figure changed by the scene
+				\details The pose of a child is stored relative to the parent, so the parent
+					has to be up to date (see hasDirtyAncestor). Descendants are only marked.
+				\param [in] index {Index of the figure}
+				\param [in] figure {The figure}
+			*/
+			void markMoved(int index, Window::Figure& figure) {
+				this->world[index] = this->poseOf(figure);
+
+				if (this->parent[index] != -1) {
+					this->local[index] = this->toLocal(this->world[this->parent[index]], this->world[index]);
+				}
+
+				if (this->first_child[index] != -1 && !this->is_dirty[index]) {
+					this->is_dirty[index] = true;
+					this->dirty.push_back(index);
+				}
+			}
+
+			/*!
+				\brief Recompute world poses below the changed figures
+				\param [in] figures {All figures of the scene}
+				\param [out] changed {Indices of figures whose pose was recomputed, cleared before filling}
+			*/
+			void update(Window::FigureList& figures, Window::TrackedVector<int, Window::MEMORY_SCENE>& changed) {
+				changed.clear();
+
+				for (size_t d = 0; d < this->dirty.size(); d++) {
+					int root = this->dirty[d];
+
+					// Subtree of a dirty ancestor includes this one
+					if (this->hasDirtyAncestor(root)) {
+						continue;
+					}
+
+					this->stack.clear();
+
+					for (int child = this->first_child[root]; child != -1; child = this->next_sibling[child]) {
+						this->stack.push_back(child);
+					}
+
+					while (!this->stack.empty()) {
+						int node = this->stack.back();
+						this->stack.pop_back();
+
+						this->world[node] = this->toWorld(this->world[this->parent[node]], this->local[node]);
+						figures[node]->setPose(
+							{ (int)lround(this->world[node].x), (int)lround(this->world[node].y) },
+							this->world[node].angle
+						);
+						changed.push_back(node);
+
+						for (int child = this->first_child[node]; child != -1; child = this->next_sibling[child]) {
+							this->stack.push_back(child);
+						}
+					}
+				}
+
+				for (size_t d = 0; d < this->dirty.size(); d++) {
+					this->is_dirty[this->dirty[d]] = false;
+				}
+
+				this->dirty.clear();
+			}
+
+		protected:
+			Window::TrackedVector<int, Window::MEMORY_HIERARCHY> parent;
+			Window::TrackedVector<int, Window::MEMORY_HIERARCHY> first_child;
+			Window::TrackedVector<int, Window::MEMORY_HIERARCHY> next_sibling;
+			Window::TrackedVector<int, Window::MEMORY_HIERARCHY> prev_sibling;
+			Window::TrackedVector<Window::Pose, Window::MEMORY_HIERARCHY> local;
+			Window::TrackedVector<Window::Pose, Window::MEMORY_HIERARCHY> world;
+			Window::TrackedVector<bool, Window::MEMORY_HIERARCHY> is_dirty;
+			Window::TrackedVector<int, Window::MEMORY_HIERARCHY> dirty;
+			Window::TrackedVector<int, Window::MEMORY_HIERARCHY> stack;
+
+			Pose poseOf(Window::Figure& figure) {
+				Window::Point position = figure.getPosition();
+
+				return { (double)position.x, (double)position.y, figure.getAngle() };
+			}
+
+			// Pose of the child relative to the parent
+			Pose toLocal(const Pose& parent, const Pose& child) {
+				double dx = child.x - parent.x;
+				double dy = child.y - parent.y;
+
+				return {
+					cos(parent.angle) * dx + sin(parent.angle) * dy,
+					-sin(parent.angle) * dx + cos(parent.angle) * dy,
+					child.angle - parent.angle,
+				};
+			}
+
+			// Pose of the child in the window
+			Pose toWorld(const Pose& parent, const Pose& local) {
+				return {
+					parent.x + cos(parent.angle) * local.x - sin(parent.angle) * local.y,
+					parent.y + sin(parent.angle) * local.x + cos(parent.angle) * local.y,
+					parent.angle + local.angle,
+				};
+			}
+
+			// Detach the node from its parent and siblings
+			void unlink(int node) {
+				int parent = this->parent[node];
+
+				if (parent == -1) {
+					return;
+				}
+
+				if (this->prev_sibling[node] != -1) {
+					this->next_sibling[this->prev_sibling[node]] = this->next_sibling[node];
+				} else {
+					this->first_child[parent] = this->next_sibling[node];
+				}
+
+				if (this->next_sibling[node] != -1) {
+					this->prev_sibling[this->next_sibling[node]] = this->prev_sibling[node];
+				}
+
+				this->parent[node] = -1;
+				this->next_sibling[node] = -1;
+				this->prev_sibling[node] = -1;
+			}
+	};
+};
+
+#endif
@@ -0,0 +1,527 @@
+#ifndef PAINTING_LAYER_H
+#define PAINTING_LAYER_H
+
+#include <math.h>
+#include <memory>
+#include <algorithm>
+
+#include "snapshot.h"
+#include "raster.h"
+
+namespace Window {
+	/*!
+		\brief Finds parts of the cached background layer to redraw between frames
+		\details Figures with a state (active, selected or highlighted by the lock mode) are
+			the foreground, they are drawn on top of the layer every frame. The rest is the
+			background, drawn into the layer once. update() compares the snapshot with the one
+			of the previous frame: chunks shared by both are skipped by pointer, figures of
+			other chunks are compared one by one, and boxes of background figures that moved,
+			appeared, disappeared or changed their state become dirty rectangles. A frame where
+			only the foreground changes has no dirty rectangles, so its cost doesn't depend on
+			the size of the background. Figures are kept in buckets of viewport tiles, updated
+			from the same comparison, so findDirtyFigures() looks only at tiles under the dirty
+			rectangles. Figures covering more than MAX_FIGURE_TILES tiles are checked always.
+		\version 1.1.0
+		\author Crinax
+	*/
+	class LayerTracker {
+		public:
+			// Reach of the widest pen past the outline
+			static const int PEN_REACH = 3;
+			// More dirty rectangles than this are merged into their bounding box
+			static const int MAX_DIRTY_RECTS = 16;
+			// Side of a tile of the figure buckets in pixels
+			static const int TILE_SIZE = 32;
+			// Figures covering more tiles are not put in buckets
+			static const int MAX_FIGURE_TILES = 64;
+
+			LayerTracker() {
+				this->viewport = { 0, 0, 0, 0 };
+				this->is_valid = false;
+				this->tile_columns = 0;
+				this->tile_rows = 0;
+			}
+
+			// Redraw the whole layer on the next update, e.g. when the layer lost its pixels
+			void invalidate() {
+				this->is_valid = false;
+			}
+
+			/*!
+				\brief Find what changed since the previous update
+				\param [in] snapshot {Snapshot of the frame}
+				\param [in] viewport {Window coords covered by the layer}
+			*/
+			void update(const Window::SceneSnapshot& snapshot, Window::ClipRect viewport) {
+				bool is_full = !this->is_valid
+					|| viewport.left != this->viewport.left
+					|| viewport.top != this->viewport.top
+					|| viewport.right != this->viewport.right
+					|| viewport.bottom != this->viewport.bottom;
+
+				this->viewport = viewport;
+				this->dirty_rects.clear();
+				this->findForeground(snapshot);
+
+				if (is_full) {
+					this->dirty_rects.push_back(viewport);
+					this->rebuildTiles(snapshot);
+				} else {
+					this->compareChunks(snapshot);
+					this->compareForeground(snapshot);
+				}
+
+				int chunk_count = snapshot.countChunks();
+
+				this->chunks.resize(chunk_count);
+
+				for (int c = 0; c < chunk_count; c++) {
+					this->chunks[c] = snapshot.getChunk(c);
+				}
+
+				this->foreground.swap(this->next_foreground);
+				this->is_valid = true;
+			}
+
+			// Returns rectangles of the layer to clear and redraw with background figures
+			const Window::TrackedVector<Window::ClipRect, Window::MEMORY_RENDERER>& getDirtyRects() {
+				return this->dirty_rects;
+			}
+
+			// Returns sorted indexes of figures to draw on top of the layer
+			const Window::TrackedVector<int, Window::MEMORY_RENDERER>& getForegroundFigures() {
+				return this->foreground;
+			}
+
+			// Returns true if the figure is drawn on top of the layer in this frame
+			bool isForeground(int index) {
+				return std::binary_search(this->foreground.begin(), this->foreground.end(), index);
+			}
+
+			/*!
+				\brief Returns true if the background figure has to be redrawn into the layer
+				\param [in] figure {The figure}
+			*/
+			bool touchesDirtyRects(Window::Figure& figure) {
+				for (size_t r = 0; r < this->dirty_rects.size(); r++) {
+					if (Window::classifyFigure(figure, this->dirty_rects[r], Window::LayerTracker::PEN_REACH) != Window::CLIP_OUTSIDE) {
+						return true;
+					}
+				}
+
+				return false;
+			}
+
+			/*!
+				\brief Returns sorted indexes of background figures to redraw into the layer
+				\details Figures of buckets under the dirty rectangles, or of the whole snapshot
+					when the buckets hold more of them, which touch the dirty rectangles.
+				\param [in] snapshot {Snapshot of the last update}
+			*/
+			const Window::TrackedVector<int, Window::MEMORY_RENDERER>& findDirtyFigures(const Window::SceneSnapshot& snapshot) {
+				size_t candidate_count = this->large_figures.size();
+
+				this->dirty_figures.clear();
+
+				for (size_t r = 0; r < this->dirty_rects.size(); r++) {
+					Window::ClipRect tiles = this->getTileRange(this->dirty_rects[r]);
+
+					for (int row = tiles.top; row < tiles.bottom; row++) {
+						for (int column = tiles.left; column < tiles.right; column++) {
+							candidate_count += this->tiles[row * this->tile_columns + column].size();
+						}
+					}
+				}
+
+				if (candidate_count >= (size_t)snapshot.countElements()) {
+					for (int i = 0; i < snapshot.countElements(); i++) {
+						this->dirty_figures.push_back(i);
+					}
+				} else {
+					for (size_t r = 0; r < this->dirty_rects.size(); r++) {
+						Window::ClipRect tiles = this->getTileRange(this->dirty_rects[r]);
+
+						for (int row = tiles.top; row < tiles.bottom; row++) {
+							for (int column = tiles.left; column < tiles.right; column++) {
+								const Window::TrackedVector<int, Window::MEMORY_RENDERER>& bucket = this->tiles[row * this->tile_columns + column];
+
+								this->dirty_figures.insert(this->dirty_figures.end(), bucket.begin(), bucket.end());
+							}
+						}
+					}
+
+					this->dirty_figures.insert(this->dirty_figures.end(), this->large_figures.begin(), this->large_figures.end());
+					std::sort(this->dirty_figures.begin(), this->dirty_figures.end());
+					this->dirty_figures.erase(
+						std::unique(this->dirty_figures.begin(), this->dirty_figures.end()),
+						this->dirty_figures.end()
+					);
+				}
+
+				size_t kept = 0;
+
+				for (size_t f = 0; f < this->dirty_figures.size(); f++) {
+					int index = this->dirty_figures[f];
+					Window::Figure figure = snapshot.getFigure(index);
+
+					if (!this->isForeground(index) && this->touchesDirtyRects(figure)) {
+						this->dirty_figures[kept++] = index;
+					}
+				}
+
+				this->dirty_figures.resize(kept);
+
+				return this->dirty_figures;
+			}
+
+		protected:
+			Window::ClipRect viewport;
+			bool is_valid;
+			int tile_columns;
+			int tile_rows;
+			// Indexes of figures whose box covers the tile, row by row
+			Window::TrackedVector<Window::TrackedVector<int, Window::MEMORY_RENDERER>, Window::MEMORY_RENDERER> tiles;
+			Window::TrackedVector<int, Window::MEMORY_RENDERER> large_figures;
+			Window::TrackedVector<int, Window::MEMORY_RENDERER> dirty_figures;
+			// Chunks of the previous frame, kept alive to compare them with the next ones
+			Window::TrackedVector<std::shared_ptr<const Window::FigureChunk>, Window::MEMORY_RENDERER> chunks;
+			Window::TrackedVector<int, Window::MEMORY_RENDERER> foreground;
+			Window::TrackedVector<int, Window::MEMORY_RENDERER> next_foreground;
+			Window::TrackedVector<Window::ClipRect, Window::MEMORY_RENDERER> dirty_rects;
+
+			// Collect foreground of the snapshot into next_foreground
+			void findForeground(const Window::SceneSnapshot& snapshot) {
+				const Window::SnapshotMask* mask = snapshot.getHighlightMask();
+
+				this->next_foreground.clear();
+
+				if (mask != NULL) {
+					for (size_t word = 0; word < mask->size(); word++) {
+						for (int bit = 0; bit < 64 && (*mask)[word] >> bit != 0; bit++) {
+							if ((*mask)[word] >> bit & 1) {
+								this->next_foreground.push_back((int)(word * 64) + bit);
+							}
+						}
+					}
+				}
+
+				if (snapshot.getActiveFigureIndex() >= 0) {
+					this->next_foreground.push_back(snapshot.getActiveFigureIndex());
+				}
+
+				if (snapshot.getSelectedFigureIndex() >= 0) {
+					this->next_foreground.push_back(snapshot.getSelectedFigureIndex());
+				}
+
+				std::sort(this->next_foreground.begin(), this->next_foreground.end());
+				this->next_foreground.erase(
+					std::unique(this->next_foreground.begin(), this->next_foreground.end()),
+					this->next_foreground.end()
+				);
+
+				while (!this->next_foreground.empty() && this->next_foreground.back() >= snapshot.countElements()) {
+					this->next_foreground.pop_back();
+				}
+			}
+
+			// Mark boxes of background figures of chunks which are not shared with the previous frame
+			void compareChunks(const Window::SceneSnapshot& snapshot) {
+				int chunk_count = std::max((int)this->chunks.size(), snapshot.countChunks());
+
+				for (int c = 0; c < chunk_count; c++) {
+					std::shared_ptr<const Window::FigureChunk> next;
+					std::shared_ptr<const Window::FigureChunk> previous;
+
+					if (c < snapshot.countChunks()) {
+						next = snapshot.getChunk(c);
+					}
+
+					if (c < (int)this->chunks.size()) {
+						previous = this->chunks[c];
+					}
+
+					if (next == previous) {
+						continue;
+					}
+
+					int previous_count = previous ? previous->count : 0;
+					int next_count = next ? next->count : 0;
+
+					for (int i = 0; i < std::max(previous_count, next_count); i++) {
+						int index = c * Window::FigureChunk::SIZE + i;
+
+						if (i < previous_count && i < next_count && this->isSameFigure(previous->figures[i], next->figures[i])) {
+							continue;
+						}
+
+						if (i < previous_count) {
+							this->removeFromTiles(index, previous->figures[i]);
+						}
+
+						if (i < next_count) {
+							this->addToTiles(index, next->figures[i]);
+						}
+
+						// Foreground figures are not in the layer, neither before nor after
+						if (i < previous_count && !std::binary_search(this->foreground.begin(), this->foreground.end(), index)) {
+							this->addFigure(previous->figures[i]);
+						}
+
+						if (i < next_count && !std::binary_search(this->next_foreground.begin(), this->next_foreground.end(), index)) {
+							this->addFigure(next->figures[i]);
+						}
+					}
+				}
+			}
+
+			// Mark boxes of figures which moved between the foreground and the layer
+			void compareForeground(const Window::SceneSnapshot& snapshot) {
+				size_t a = 0;
+				size_t b = 0;
+
+				while (a < this->foreground.size() || b < this->next_foreground.size()) {
+					int index;
+
+					if (b == this->next_foreground.size() || (a < this->foreground.size() && this->foreground[a] < this->next_foreground[b])) {
+						index = this->foreground[a++];
+					} else if (a == this->foreground.size() || this->next_foreground[b] < this->foreground[a]) {
+						index = this->next_foreground[b++];
+					} else {
+						a++;
+						b++;
+						continue;
+					}
+
+					if (index < snapshot.countElements()) {
+						this->addFigure(snapshot.getFigure(index));
+					}
+				}
+			}
+
+			bool isSameFigure(Window::Figure first, Window::Figure second) {
+				return first.is_initialized == second.is_initialized
+					&& first.getPosition().x == second.getPosition().x
+					&& first.getPosition().y == second.getPosition().y
+					&& first.getRadius() == second.getRadius()
+					&& first.getAngle() == second.getAngle()
+					&& first.getTemplate() == second.getTemplate();
+			}
+
+			// Put the figure in buckets of all viewport tiles
+			void rebuildTiles(const Window::SceneSnapshot& snapshot) {
+				this->tile_columns = (this->viewport.right - this->viewport.left + Window::LayerTracker::TILE_SIZE - 1) / Window::LayerTracker::TILE_SIZE;
+				this->tile_rows = (this->viewport.bottom - this->viewport.top + Window::LayerTracker::TILE_SIZE - 1) / Window::LayerTracker::TILE_SIZE;
+				this->tile_columns = std::max(this->tile_columns, 0);
+				this->tile_rows = std::max(this->tile_rows, 0);
+				this->tiles.resize((size_t)this->tile_columns * this->tile_rows);
+				this->large_figures.clear();
+
+				for (size_t t = 0; t < this->tiles.size(); t++) {
+					this->tiles[t].clear();
+				}
+
+				for (int i = 0; i < snapshot.countElements(); i++) {
+					this->addToTiles(i, snapshot.getFigure(i));
+				}
+			}
+
+			void addToTiles(int index, Window::Figure figure) {
+				Window::ClipRect box;
+
+				if (!this->getFigureBox(figure, box)) {
+					return;
+				}
+
+				Window::ClipRect tiles = this->getTileRange(box);
+
+				if ((tiles.right - tiles.left) * (tiles.bottom - tiles.top) > Window::LayerTracker::MAX_FIGURE_TILES) {
+					this->large_figures.push_back(index);
+					return;
+				}
+
+				for (int row = tiles.top; row < tiles.bottom; row++) {
+					for (int column = tiles.left; column < tiles.right; column++) {
+						this->tiles[row * this->tile_columns + column].push_back(index);
+					}
+				}
+			}
+
+			// The figure has to be the one added with the index, so it covers the same tiles
+			void removeFromTiles(int index, Window::Figure figure) {
+				Window::ClipRect box;
+
+				if (!this->getFigureBox(figure, box)) {
+					return;
+				}
+
+				Window::ClipRect tiles = this->getTileRange(box);
+
+				if ((tiles.right - tiles.left) * (tiles.bottom - tiles.top) > Window::LayerTracker::MAX_FIGURE_TILES) {
+					this->removeFromBucket(this->large_figures, index);
+					return;
+				}
+
+				for (int row = tiles.top; row < tiles.bottom; row++) {
+					for (int column = tiles.left; column < tiles.right; column++) {
+						this->removeFromBucket(this->tiles[row * this->tile_columns + column], index);
+					}
+				}
+			}
+
+			void removeFromBucket(Window::TrackedVector<int, Window::MEMORY_RENDERER>& bucket, int index) {
+				for (size_t b = 0; b < bucket.size(); b++) {
+					if (bucket[b] == index) {
+						bucket[b] = bucket.back();
+						bucket.pop_back();
+						return;
+					}
+				}
+			}
+
+			// Returns tiles covered by the box in the viewport, right and bottom are exclusive
+			Window::ClipRect getTileRange(Window::ClipRect box) {
+				return {
+					(box.left - this->viewport.left) / Window::LayerTracker::TILE_SIZE,
+					(box.top - this->viewport.top) / Window::LayerTracker::TILE_SIZE,
+					(box.right - this->viewport.left - 1) / Window::LayerTracker::TILE_SIZE + 1,
+					(box.bottom - this->viewport.top - 1) / Window::LayerTracker::TILE_SIZE + 1,
+				};
+			}
+
+			// Find bounding box of the figure and its pen in the viewport, false if it's outside
+			bool getFigureBox(Window::Figure figure, Window::ClipRect& box) {
+				if (!figure.is_initialized) {
+					return false;
+				}
+
+				Window::Point center = figure.getPosition();
+				double reach = fabs((double)figure.getRadius()) + Window::LayerTracker::PEN_REACH + Window::CLIP_ROUNDING;
+				double left = std::max((double)this->viewport.left, floor(center.x - reach));
+				double top = std::max((double)this->viewport.top, floor(center.y - reach));
+				double right = std::min((double)this->viewport.right, ceil(center.x + reach) + 1);
+				double bottom = std::min((double)this->viewport.bottom, ceil(center.y + reach) + 1);
+
+				if (!(left < right) || !(top < bottom)) {
+					return false;
+				}
+
+				box = { (int)left, (int)top, (int)right, (int)bottom };
+
+				return true;
+			}
+
+			// Add bounding box of the figure and its pen as a dirty rectangle
+			void addFigure(Window::Figure figure) {
+				Window::ClipRect box;
+
+				if (Window::classifyFigure(figure, this->viewport, Window::LayerTracker::PEN_REACH) == Window::CLIP_OUTSIDE || !this->getFigureBox(figure, box)) {
+					return;
+				}
+
+				if (this->dirty_rects.size() < (size_t)Window::LayerTracker::MAX_DIRTY_RECTS) {
+					this->dirty_rects.push_back(box);
+					return;
+				}
+
+				Window::ClipRect& bounds = this->dirty_rects[0];
+
+				for (size_t r = 1; r < this->dirty_rects.size(); r++) {
+					bounds.left = std::min(bounds.left, this->dirty_rects[r].left);
+					bounds.top = std::min(bounds.top, this->dirty_rects[r].top);
+					bounds.right = std::max(bounds.right, this->dirty_rects[r].right);
+					bounds.bottom = std::max(bounds.bottom, this->dirty_rects[r].bottom);
+				}
+
+				bounds.left = std::min(bounds.left, box.left);
+				bounds.top = std::min(bounds.top, box.top);
+				bounds.right = std::max(bounds.right, box.right);
+				bounds.bottom = std::max(bounds.bottom, box.bottom);
+				this->dirty_rects.resize(1);
+			}
+	};
+
+	/*!
+		\brief Software renderer of snapshots with the cached background layer
+		\details Every frame redraws dirty rectangles of the layer, copies the layer to the
+			frame and draws foreground figures on top of it, see LayerTracker. Outlines of the
+			foreground are above the background even where the scene order is the other way.
+		\version 1.1.0
+		\author Crinax
+	*/
+	class LayerRenderer {
+		public:
+			LayerRenderer() : layer(0, 0) {}
+
+			/*!
+				\brief Draw the snapshot into the frame
+				\param [in] snapshot {The snapshot}
+				\param [in] frame {The framebuffer, any size and origin}
+			*/
+			void render(const Window::SceneSnapshot& snapshot, Window::Framebuffer& frame) {
+				frame.resetClip();
+
+				Window::ClipRect viewport = frame.getClipRect();
+
+				if (this->layer.getWidth() != frame.getWidth() || this->layer.getHeight() != frame.getHeight()) {
+					this->layer.resize(frame.getWidth(), frame.getHeight());
+					this->tracker.invalidate();
+				}
+
+				this->layer.setOrigin(frame.getOrigin());
+				this->tracker.update(snapshot, viewport);
+
+				const Window::TrackedVector<Window::ClipRect, Window::MEMORY_RENDERER>& dirty_rects = this->tracker.getDirtyRects();
+
+				if (!dirty_rects.empty()) {
+					this->redrawLayer(snapshot, dirty_rects);
+				}
+
+				frame.copyFrom(this->layer);
+
+				const Window::TrackedVector<int, Window::MEMORY_RENDERER>& foreground = this->tracker.getForegroundFigures();
+
+				for (size_t f = 0; f < foreground.size(); f++) {
+					Window::Figure figure = snapshot.getFigure(foreground[f]);
+					unsigned char state = snapshot.getFigureState(foreground[f]);
+
+					frame.drawFigure(figure, Window::getFigurePen(
+						(state & Window::Scene::FIGURE_ACTIVE) != 0,
+						(state & Window::Scene::FIGURE_SELECTED) != 0
+					));
+				}
+			}
+
+			// Forget the layer, the next frame draws the whole background
+			void invalidate() {
+				this->tracker.invalidate();
+			}
+
+		protected:
+			Window::LayerTracker tracker;
+			Window::Framebuffer layer;
+
+			void redrawLayer(const Window::SceneSnapshot& snapshot, const Window::TrackedVector<Window::ClipRect, Window::MEMORY_RENDERER>& dirty_rects) {
+				Window::Pen pen = Window::getFigurePen(false, false);
+
+				for (size_t r = 0; r < dirty_rects.size(); r++) {
+					this->layer.setClip(dirty_rects[r]);
+					this->layer.fillClip(Window::background_color);
+				}
+
+				const Window::TrackedVector<int, Window::MEMORY_RENDERER>& dirty_figures = this->tracker.findDirtyFigures(snapshot);
+
+				for (size_t f = 0; f < dirty_figures.size(); f++) {
+					Window::Figure figure = snapshot.getFigure(dirty_figures[f]);
+
+					for (size_t r = 0; r < dirty_rects.size(); r++) {
+						this->layer.setClip(dirty_rects[r]);
+						this->layer.drawFigure(figure, pen);
+					}
+				}
+
+				this->layer.resetClip();
+			}
+	};
+};
+
+#endif
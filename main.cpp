@@ -1,1045 +1,609 @@
-#include <windows.h>
-#include <math.h>
-#include <string>
-#include <stdio.h>
-#include <iostream>
-#include <stdexcept>
-#include <vector>
-
-/*!
-	\brief Define namespace to avoid names conflict
-	\version 1.0.0
-	\date 10.04.2022
-	\author Crinax
-*/
-namespace Window {
-	/*!
-		\brief Structure for dots with coords x and y
-		\version 1.0.0
-		\date 10.04.2022
-		\author Crinax
-	*/
-	struct Point {
-		int x;
-		int y;
-	};
-
-	// Определяем константы
-	const double pi = 3.14;
-	const double rotate_angle = pi / 12;
-
-	/*!
-		\brief Class for figures
-		\version 1.4.0
-		\date 10.04.2022
-		\author Crinax
-	*/
-	class Figure {
-		public:
-			/*! 
-				\brief Empty constructor to initialization without params.
-				\details If you initialized class with this constructor help, field is_initialized equals false
-			*/
-			Figure() {
-				this->is_initialized = false;
-			}
-
-			/*!
-				\brief Main constructor for class
-				\param [in] vertices_number {Number of vertices of the figure (MAX_VERTICES=10)}
-				\param [in] coords {Coords of center of the figure}
-				\param [in] radius {Radius of circumscribed circle around the figure}
-				\param [in] angle {Angle of rotation of the figure}
-				\param [in] is_active {Determines whether the shape is active}
-			*/
-			Figure(
-				int vertices_number,
-				Window::Point coords,
-				int radius,
-				double angle,
-				bool is_active
-			) {
-				if (vertices_number > Window::Figure::MAX_VERTICES) {
-					throw std::out_of_range("Window::Figure: Too many vertices");
-				}
-
-				this->vertices_number = vertices_number;
-				this->coords = coords;
-				this->radius = radius;
-				this->angle = angle;
-				this->is_active = is_active;
-				this->is_selected = false;
-
-				this->updateVertices();
-
-				this->is_initialized = true;
-			}
-
-			bool is_initialized;
-			static const int MAX_VERTICES = 10;
-			
-			// Returns coors of center of the figure
-			Window::Point getPosition() {
-				return this->coords;
-			}
-
-			// Returns radius of circle
-			int getRadius() {
-				return this->radius;
-			}
-			
-			// Returns angle of rotation of the figure
-			double getAngle() {
-				return this->angle;
-			}
-
-			// Returns pointer for all vertices
-			Window::Point* getVertices() {
-				return this->vertex;
-			}
-
-			// Returns number of vertices
-			int countVertices() {
-				return this->vertices_number;
-			}
-
-			// Returns true if this figure is active
-			bool isActive() {
-				return this->is_active;
-			}
-
-			// Returns true if this figure is selected
-			bool isSelected() {
-				return this->is_selected;
-			}
-
-			/*!
-				\brief Set circle radius
-				\param [in] radius {New radius of the figure}
-			*/
-			void setRadius(int radius) {
-				this->radius = radius;
-
-				this->updateVertices();
-			}
-
-			/*!
-				\brief Set angle of rotation of the figure
-				\param [in] angle {New angle of rotation}
-			*/
-			void setAngle(double angle) {
-				this->angle = angle;
-
-				this->updateVertices();
-			}
-
-			// Disable figure
-			void disable() {
-				this->is_active = false;
-			}
-
-			// Enable figure
-			void enable() {
-				this->is_active = true;
-			}
-
-			// Select figure
-			void select() {
-				this->is_selected = true;
-			}
-
-			// Deselect figure
-			void deselect() {
-				this->is_selected = false;
-			}
-
-			// Toggle figure active
-			void toggleActive() {
-				this->is_active = !this->is_active;
-			}
-
-			// Toggle figure selection
-			void toggleSelect() {
-				this->is_selected = !this->is_selected;
-			}
-
-			/*!
-				\brief Scale of the figure
-				\param [in] pixels {How many pixels the figure increases by}
-			*/
-			void scale(int pixels) {
-				this->radius += pixels;
-
-				this->updateVertices();
-			}
-
-			/*!
-				\brief Move figure to point
-				\param [in] point {What point to move the figure to}
-			*/
-			void moveTo(Window::Point point) {
-				this->coords.x = point.x;
-				this->coords.y = point.y;
-
-				this->updateVertices();
-			}
-
-			/*!
-				\brief Rotate the figure
-				\param [in] angle {How many radians the figure rotate by}
-			*/
-			void rotate(double angle) {
-				this->angle += angle;
-
-				this->updateVertices();
-			}
-
-			/*!
-				\brief Rotate the figure around point
-				\param [in] point {The point around which the turn will be}
-				\param [in] angle {How many radians the figure rotate by}
-			*/
-			void rotateAround(Window::Point point, double angle) {
-				double distance = sqrt(
-					pow(point.x - this->coords.x, 2)
-					+ pow(point.y - this->coords.y, 2)
-				);
-
-				Window::Point new_coords = {
-					(int)((this->coords.x - point.x) * cos(angle) - (this->coords.y - point.y) * sin(angle) + point.x),
-					(int)((this->coords.x - point.x) * sin(angle) + (this->coords.y - point.y) * cos(angle) + point.y),
-				};
-
-				this->coords = new_coords;
-
-				this->updateVertices();
-			}
-
-		protected:
-			Window::Point vertex[Window::Figure::MAX_VERTICES];
-			int vertices_number;
-			Window::Point coords;
-			int radius;
-			double angle;
-			bool is_active;
-			bool is_selected;
-
-			// Update the vertices position of the figure
-			void updateVertices() {
-				for (int i = 0; i < this->vertices_number; i++) {
-					this->vertex[i] = {
-						(int)(this->coords.x + this->radius * cos(this->angle + 2 * Window::pi * i / this->vertices_number)),
-						(int)(this->coords.y + this->radius * sin(this->angle + 2 * Window::pi * i / this->vertices_number)),
-					};
-				}
-			}
-	};
-
-	/*!
-		\brief Scene class for defining figures and them management
-		\version 1.5.0
-		\author Crinax
-		\date 10.04.2022
-	*/
-	class Scene {
-		public:
-			Scene() {
-				this->element_count = 0;
-				this->active_figure = -1;
-				this->selected_figure = -1;
-				this->is_blocked = false;
-				this->active_figure_before_block = -1;
-				this->selected_figure_before_block = -1;
-				this->figures = {};
-			}
-			
-			~Scene() {
-				this->figures.clear();
-				this->figures.shrink_to_fit();
-			}
-
-			/*!
-				\brief Returns the figure by index, if the index > max figures throws error
-				\param [in] index {Index of the figure}
-			*/
-			Figure getFigure(int index) {
-				if (index >= this->element_count) {
-					throw std::out_of_range("[ERR] Window::Scene: index greeter than max possible figures");
-				}
-
-				return this->figures[index];
-			}
-
-			/*!
-				\brief Creates new figure
-				\param [in] center {Coords of center of the figure}
-				\param [in] radius {Radius of circumscribed circle around the figure}
-				\param [in] vertices_number {Number of vertices of the figure (MAX_VERTICES=10)}
-				\param [in] angle {Angle of rotation of the figure}
-				\param [in] is_active {Determines whether the shape is active}
-			*/
-			void newFigure(Point center, int radius, int vertices_number, double angle, bool is_active) {
-				this->figures.push_back({
-					vertices_number,
-					center,
-					radius,
-					angle,
-					is_active,
-				});
-				
-
-				this->disableFigures(this->element_count);
-				this->active_figure = this->element_count;
-
-				this->element_count++;
-			}
-
-			/*!
-				\brief Rotate the active figure
-				\param [in] angle {How many radians the figure rotate by}
-			*/
-			void rotateActiveFigure(double angle) {
-				this->checkFiguresLength();
-				this->checkIsSceneBlocking();
-
-				this->figures[this->active_figure].rotate(angle);
-			}
-
-			/*!
-				\brief Switch active figure to previous
-				\bug Doesn't work correctly
-				\todo Fix the switching
-			*/
-			void setPrevFigureAsActive() {
-				this->checkFiguresLength();
-				this->checkIsSceneBlocking();
-
-				this->figures[this->active_figure].disable();
-
-				this->decreaseActiveFigureIndex();
-
-				this->figures[this->active_figure].enable();
-			}
-
-			/*!
-				\brief Switch active figure to next
-			*/
-			void setNextFigureAsActive() {
-				this->checkFiguresLength();
-				this->checkIsSceneBlocking();
-
-				this->figures[this->active_figure].disable();
-
-				this->increaseActiveFigureIndex();
-
-				this->figures[this->active_figure].enable();
-			}
-
-			/*!
-				\brief Move the active figure to point
-				\param [in] point {What point to move the figure to}
-			*/
-			void moveActiveFigureTo(Window::Point point) {
-				this->checkFiguresLength();
-				this->checkIsSceneBlocking();
-
-				this->figures[this->active_figure].moveTo(point);
-			}
-
-			/*!
-				\brief Move the active figure to selected
-				\param [in] point {What point to move the figure to}
-			*/
-			void moveActiveFigureToSelected() {
-				this->checkFiguresLength();
-				this->checkIsSceneBlocking();
-
-				if (this->selected_figure == -1) {
-					throw std::runtime_error("[ERR] Window::Scene: No selected figures");
-				}
-
-				this->figures[this->active_figure].moveTo(this->figures[this->selected_figure].getPosition());
-			}
-
-			// Increase the active figure radius by 1
-			void increaseActiveFigureRadius() {
-				this->checkFiguresLength();
-				this->checkIsSceneBlocking();
-
-				this->figures[this->active_figure].scale(1);
-			}
-
-			// Decrease the active figure radius by 1
-			void decreaseActiveFigureRadius() {
-				this->checkFiguresLength();
-				this->figures[this->active_figure].scale(-1);
-			}
-
-			// Delete active figure with switching active figure to previous
-			void deleteActiveFigure() {
-				this->checkFiguresLength();
-				this->checkIsSceneBlocking();
-
-				this->element_count--;
-				this->figures.erase(this->figures.begin() + this->active_figure);
-
-				if (this->active_figure == this->element_count) {
-					this->active_figure--;
-				}
-				
-				if (this->active_figure == 0) {
-					this->active_figure = this->element_count - 1;
-				}
-
-				if (this->active_figure == this->selected_figure) {
-					this->selected_figure = -1;
-				}
-
-				this->figures[this->active_figure].enable();
-			}
-
-			/*!
-				\brief Rotate all figures
-				\param [in] angle {How many radians the figures rotate by}
-			*/
-			void rotateAllFigures(double angle) {
-				this->checkFiguresLength();
-				this->checkIsSceneBlocking();
-
-				for (int i = 0; i < this->element_count; i++) {
-					if (this->figures[i].is_initialized) {
-						this->figures[i].rotate(angle);
-					}
-				}
-			}
-
-			// Select active figure
-			void selectActiveFigure() {
-				this->checkFiguresLength();
-				this->checkIsSceneBlocking();
-				
-				if (this->selected_figure == this->active_figure) {
-					this->selected_figure = -1;
-				} else {
-					if (this->selected_figure != -1) {
-						this->figures[this->selected_figure].deselect();
-					}
-
-					this->selected_figure = this->active_figure;
-				}
-				
-				this->figures[this->active_figure].toggleSelect();
-			}
-
-			/*!
-				\brief Rotate figure around selected figure or around self
-				\param [in] angle {How many radians the figures rotate by}
-			*/
-			void rotateActiveFigureAroundSelected(double angle) {
-				this->checkFiguresLength();
-				this->checkIsSceneBlocking();
-
-				if (this->selected_figure == this->active_figure || this->selected_figure == -1) {
-					this->figures[this->active_figure].rotate(angle);
-				} else {
-					this->figures[this->active_figure].rotateAround(
-						this->figures[this->selected_figure].getPosition(),
-						angle
-					);
-				}
-			}
-
-			/*!
-				\brief Rotate figure around point
-				\param [in] point {The point around which to turn}
-				\param [in] angle {How many radians the figures rotate by}
-			*/
-			void rotateActiveFigureAroundPoint(Window::Point point, double angle) {
-				this->checkFiguresLength();
-				this->checkIsSceneBlocking();
-
-				this->figures[this->active_figure].rotateAround(
-					point,
-					angle
-				);
-			}
-
-			// Deleting all figures from sceen
-			void deleteAllFigures() {
-				this->element_count = 0;
-				this->active_figure = -1;
-				this->selected_figure = -1;
-
-				this->figures.clear();
-			}
-
-			void lockScene() {
-				this->checkFiguresLength();
-
-				this->figures[active_figure].disable();
-
-				if (this->selected_figure != -1) {
-					this->figures[this->selected_figure].deselect();
-				}
-				
-				this->active_figure_before_block = this->active_figure;
-				this->selected_figure_before_block = this->selected_figure;
-				this->active_figure = -1;
-				this->selected_figure = -1;
-				this->is_blocked = true;
-			}
-
-			void unlockScene() {
-				this->checkFiguresLength();
-
-				this->active_figure = this->active_figure_before_block;
-				this->selected_figure = this->selected_figure_before_block;
-				this->active_figure_before_block = -1;
-				this->selected_figure_before_block = -1;
-				this->is_blocked = false;
-			}
-
-			void restoreAfterBlocking() {
-				for (int i = 0; i < this->element_count; i++) {
-					if (this->figures[i].isActive()) {
-						this->figures[i].disable();
-					}
-				}
-
-				this->figures[this->active_figure].enable();
-
-				if (this->selected_figure != -1) {
-					this->figures[this->selected_figure].select();
-				}
-			}
-
-			void setLargestFigureAsActiveByVerticesCount(int vertices_count) {
-				this->checkFiguresLength();
-
-				int figure_index = this->getLargeFigureByVerticesCount(vertices_count);
-
-				if (figure_index != -1) {
-					this->figures[figure_index].enable();
-				}
-			}
-
-			void setAllLargestFigureAsActive() {
-				this->checkFiguresLength();
-
-				for (int i = 3; i <= Window::Figure::MAX_VERTICES; i++) {
-					this->setLargestFigureAsActiveByVerticesCount(i);
-				}
-			}
-
-			bool isBlocked() {
-				return this->is_blocked;
-			}
-
-			int countElements() {
-				return this->element_count;
-			}
-
-		protected:
-			int element_count;
-			int active_figure;
-			int selected_figure;
-			bool is_blocked;
-			int active_figure_before_block;
-			int selected_figure_before_block;
-			std::vector<Window::Figure> figures;
-
-			// Throws error if the figures length == 0
-			void checkFiguresLength() {
-				if (this->element_count < 1) {
-					throw std::runtime_error("[ERR] Window::Scene: No figures to do this action");
-				}
-			}
-
-			void checkIsSceneBlocking() {
-				if (this->is_blocked) {
-					throw std::runtime_error("[ERR] Window::Scene: Scene was blocked");
-				}
-			}
-
-			int getLargeFigureByVerticesCount(int vertices_count) {
-				this->checkFiguresLength();
-
-				int large_figure_index = 0;
-				bool large_figure_was_found = false;
-
-				for (int i = 0; i < this->element_count; i++) {
-					if (this->figures[i].countVertices() == vertices_count) {
-						if (this->figures[large_figure_index].getRadius() <= this->figures[i].getRadius()) {
-							large_figure_index = i;
-							large_figure_was_found = true;
-						}
-					}
-				}
-
-				if (large_figure_was_found) {
-					return large_figure_index;
-				}
-
-				return -1;
-			}
-
-			/*!
-				\brief Disable figure by index
-				\param [in] index {Index of the figure}
-			*/
-			void disableFigures(int order) {
-				for (int i = 0; i < this->element_count; i++) {
-					if (this->figures[i].is_initialized) {
-						this->figures[i].disable();
-					}
-				}
-			}
-
-			// Increase active figure index
-			void increaseActiveFigureIndex() {
-				if (this->active_figure == this->element_count - 1) {
-					this->active_figure = 0;
-				} else {
-					this->active_figure++;
-				}
-			}
-
-			// Decrease active figure index
-			void decreaseActiveFigureIndex() {
-				if (this->active_figure == 0) {
-					this->active_figure = this->element_count - 1;
-				} else {
-					this->active_figure--;
-				}
-			}
-	};
-};
-
-Window::Scene mainScene = {};
-
-LRESULT CALLBACK WndProc(HWND hwnd, UINT Message, WPARAM wParam, LPARAM lParam) {
-	HDC hDC;
-	PAINTSTRUCT ps;
-	RECT rect;
-
-	switch(Message) {
-		case WM_DESTROY: {
-			PostQuitMessage(0);
-			break;
-		}
-
-		case WM_PAINT: {
-			hDC = BeginPaint(hwnd, &ps);
-			HPEN old_brush;
-			HPEN active_pen = CreatePen(PS_SOLID, 5, RGB(255, 0, 0));
-			HPEN nonactive_pen = CreatePen(PS_SOLID, 1, RGB(255, 0, 0));
-			HPEN active_selected_pen = CreatePen(PS_SOLID, 5, RGB(0, 0, 255));
-			HPEN nonactive_selected_pen = CreatePen(PS_SOLID, 1, RGB(0, 0, 255));
-			
-			int element_count = mainScene.countElements();
-
-			for (int i = 0; i < element_count; i++) {
-				Window::Figure figure = mainScene.getFigure(i);
-
-				if (figure.is_initialized) {
-					if (figure.isActive()) {
-						if (figure.isSelected()) {
-							old_brush = (HPEN)SelectObject(hDC, active_selected_pen);
-						} else {
-							old_brush = (HPEN)SelectObject(hDC, active_pen);
-						}
-					} else {
-						if (figure.isSelected()) {
-							old_brush = (HPEN)SelectObject(hDC, nonactive_selected_pen);
-						} else {
-							old_brush = (HPEN)SelectObject(hDC, nonactive_pen);
-						}
-					}
-
-					int vertices_count = figure.countVertices();
-					Window::Point* vertices = figure.getVertices();
-
-					MoveToEx(hDC, vertices[0].x, vertices[0].y, NULL);
-					
-					for (int i = 1; i < vertices_count; i++) {
-						LineTo(hDC, vertices[i].x, vertices[i].y);
-					}
-
-					LineTo(hDC, vertices[0].x, vertices[0].y);
-				}
-				
-				SelectObject(hDC, old_brush);
-			}
-
-			EndPaint(hwnd, &ps);
-			break;
-		}
-
-		case WM_KEYDOWN: {
-			switch (wParam) {
-				case VK_F1: {
-					Window::Point center = { 100, 100 };
-					
-					try {
-						mainScene.newFigure(center, 50, 3, Window::pi, true);
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_F2: {
-					Window::Point center = { 200, 200 };
-					
-					try {
-						mainScene.newFigure(center, 50, 4, Window::pi, true);
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_F3: {
-					Window::Point center = { 300, 300 };
-					
-					try {
-						mainScene.newFigure(center, 50, 4, Window::pi / 4, true);
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_F4: {
-					Window::Point center = { 300, 300 };
-					
-					try {
-						mainScene.newFigure(center, 50, 6, 0, true);
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-					
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_F12: {
-					try {
-						mainScene.rotateActiveFigure(Window::rotate_angle);
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_F11: {
-					try {
-						mainScene.rotateActiveFigure(-Window::rotate_angle);
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_F6: {
-					try {
-						mainScene.rotateAllFigures(Window::rotate_angle);
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_F5: {
-					try {
-						mainScene.rotateAllFigures(-Window::rotate_angle);
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_F7: {
-					try {
-						mainScene.rotateActiveFigureAroundSelected(-Window::rotate_angle);
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_F8: {
-					try {
-						mainScene.rotateActiveFigureAroundSelected(Window::rotate_angle);
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_F9: {
-					try {
-						if (mainScene.isBlocked()) {
-							mainScene.unlockScene();
-							mainScene.restoreAfterBlocking();
-						} else {
-							mainScene.lockScene();
-							mainScene.setAllLargestFigureAsActive();
-						}
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_SPACE: {
-					try {
-						mainScene.selectActiveFigure();
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_LEFT: {
-					try {
-						mainScene.setPrevFigureAsActive();
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_RIGHT: {
-					try {
-						mainScene.setNextFigureAsActive();
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_UP: {
-					try {
-						mainScene.increaseActiveFigureRadius();
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-
-					break;
-				}
-
-				case VK_DOWN: {
-					try {
-						mainScene.decreaseActiveFigureRadius();
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-					
-					break;
-				}
-
-				case VK_DELETE: {
-					try {
-						mainScene.deleteActiveFigure();
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-					
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-					
-					break;
-				}
-
-				case VK_BACK: {
-					try {
-						mainScene.deleteAllFigures();
-					} catch (const std::exception& err) {
-						std::cout << err.what() << std::endl;
-					}
-
-					GetClientRect(hwnd, &rect);
-					InvalidateRect(hwnd, &rect, -1);
-					UpdateWindow(hwnd);
-					
-					break;
-				}
-			}
-
-			break;
-		}
-
-		case WM_LBUTTONDOWN: {
-			int mouse_x = LOWORD(lParam);
-			int mouse_y = HIWORD(lParam);
-			
-			try {
-				mainScene.moveActiveFigureTo({ mouse_x, mouse_y });
-			} catch (const std::exception& err) {
-				std::cout << err.what() << std::endl;
-			}
-
-			GetClientRect(hwnd, &rect);
-			InvalidateRect(hwnd, &rect, -1);
-			UpdateWindow(hwnd);
-
-			break;
-		}
-
-		case WM_MBUTTONDOWN: {
-			try {
-				mainScene.moveActiveFigureToSelected();
-			} catch (const std::exception& err) {
-				std::cout << err.what() << std::endl;
-			}
-
-			GetClientRect(hwnd, &rect);
-			InvalidateRect(hwnd, &rect, -1);
-			UpdateWindow(hwnd);
-
-			break;
-		}
-
-		case WM_RBUTTONDOWN: {
-			int mouse_x = LOWORD(lParam);
-			int mouse_y = HIWORD(lParam);
-
-			try {
-				mainScene.rotateActiveFigure(Window::pi);
-				mainScene.rotateActiveFigureAroundPoint({ mouse_x, mouse_y }, Window::pi);
-			} catch (const std::exception& err) {
-				std::cout << err.what() << std::endl;
-			}
-
-			GetClientRect(hwnd, &rect);
-			InvalidateRect(hwnd, &rect, -1);
-			UpdateWindow(hwnd);
-
-			break;
-		}
-
-		default:
-			return DefWindowProc(hwnd, Message, wParam, lParam);
-	}
-
-	return 0;
-}
-
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
-	WNDCLASSEX wc; 
-	HWND hwnd; 
-	MSG msg; 
-
-	memset(&wc, 0, sizeof(wc));
-	wc.cbSize = sizeof(WNDCLASSEX);
-	wc.lpfnWndProc = WndProc; 
-	wc.hInstance = hInstance;
-	wc.hCursor = LoadCursor(NULL, IDC_ARROW);
-	wc.hbrBackground = (HBRUSH)(COLOR_WINDOW+1);
-	wc.lpszClassName = "WindowClass";
-	wc.hIcon = LoadIcon(NULL, IDI_APPLICATION);
-	wc.hIconSm = LoadIcon(NULL, IDI_APPLICATION);
-
-	if(!RegisterClassEx(&wc)) {
-		MessageBox(NULL, "Window Registration Failed!", "Error!", MB_ICONEXCLAMATION | MB_OK);
-		return 0;
-	}
-
-	hwnd = CreateWindowEx(WS_EX_CLIENTEDGE, "WindowClass", "Ya verstal", WS_VISIBLE | WS_OVERLAPPEDWINDOW,
-		CW_USEDEFAULT, 
-		CW_USEDEFAULT, 
-		640, 
-		480, 
-		NULL, NULL, hInstance, NULL
-	);
-
-	if(hwnd == NULL) {
-		MessageBox(NULL, "Window Creation Failed!", "Error!", MB_ICONEXCLAMATION | MB_OK);
-		return 0;
-	}
-
-	while(GetMessage(&msg, NULL, 0, 0) > 0) { 
-		TranslateMessage(&msg);
-		DispatchMessage(&msg);
-	}
-
-	return msg.wParam;
+// Sockets of the stream have to come before windows.h, which brings the old winsock
+#include <winsock2.h>
+#include <windows.h>
+#include <stdio.h>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "scene.h"
+#include "export.h"
+#include "snapshot.h"
+#include "layer.h"
+#include "commands.h"
+#include "trace.h"
+#include "stream.h"
+
+/*!
+	\brief Enable memory telemetry when the program is started with --memory
+	\details Called before the scene is created, so all of its memory is counted
+*/
+bool startMemoryTelemetry() {
+	if (strstr(GetCommandLineA(), "--memory") == NULL) {
+		return false;
+	}
+
+	Window::MemoryTelemetry::getShared().enable();
+
+	return true;
+}
+
+bool isMemoryTracked = startMemoryTelemetry();
+
+Window::Scene mainScene = {};
+// Scene is edited in WndProc, the paint thread reads published snapshots only
+Window::SnapshotPublisher mainSnapshots(mainScene);
+int paintReaderSlot = mainSnapshots.registerReader();
+
+// Input is recorded when the program is started with --record <trace>
+Window::TraceRecorder* inputRecorder = NULL;
+int inputTraceFile = -1;
+
+// Changes are streamed to viewers when the program is started with --stream <socket>
+Window::StreamServer* sceneStream = NULL;
+const UINT_PTR STREAM_TIMER = 1;
+
+// Frames are rendered by the paint thread, so a slow frame doesn't stall input.
+// WndProc requests frames with the size of the window, the latest request wins.
+HWND paintWindow = NULL;
+std::thread paintThread;
+std::mutex paintRequestMutex;
+std::condition_variable paintRequested;
+bool isPaintRequested = false;
+bool isPaintStopping = false;
+int paintWidth = 0;
+int paintHeight = 0;
+
+// Finished frame, WM_PAINT copies it to the window
+std::mutex frameMutex;
+HDC frameDC = NULL;
+HBITMAP frameBitmap = NULL;
+
+// Objects of the paint thread only. Pens of figures indexed by their state flags
+HPEN figurePens[4];
+
+// Background figures are drawn into the layer bitmap, only its dirty parts are redrawn
+Window::LayerTracker paintLayer;
+HDC layerDC = NULL;
+HBITMAP layerBitmap = NULL;
+int layerWidth = 0;
+int layerHeight = 0;
+
+/*!
+	\brief Draw the outline of the figure with the selected pen
+	\details Outlines crossing the rectangle are clipped, the widest pen reaches 3 pixels
+	\param [in] hDC {The device context}
+	\param [in] figure {The figure}
+	\param [in] rect {Part of the window which is drawn}
+*/
+void drawFigureOutline(HDC hDC, Window::Figure& figure, const Window::ClipRect& rect) {
+	const int pen_reach = 3;
+	Window::ClipClass clip_class = Window::classifyFigure(figure, rect, pen_reach);
+
+	if (!figure.is_initialized || clip_class == Window::CLIP_OUTSIDE) {
+		return;
+	}
+
+	if (clip_class == Window::CLIP_CROSSING) {
+		Window::ClipSegment segments[Window::Figure::MAX_VERTICES];
+		int segment_count = Window::clipFigure(figure, rect, pen_reach, segments);
+
+		for (int s = 0; s < segment_count; s++) {
+			MoveToEx(hDC, segments[s].from.x, segments[s].from.y, NULL);
+			LineTo(hDC, segments[s].to.x, segments[s].to.y);
+		}
+
+		return;
+	}
+
+	Window::Point vertices[Window::Figure::MAX_VERTICES];
+	int vertices_count = figure.getVertices(vertices);
+
+	MoveToEx(hDC, vertices[0].x, vertices[0].y, NULL);
+
+	for (int v = 1; v < vertices_count; v++) {
+		LineTo(hDC, vertices[v].x, vertices[v].y);
+	}
+
+	LineTo(hDC, vertices[0].x, vertices[0].y);
+}
+
+/*!
+	\brief Create the layer and the frame bitmaps of the size of the window, the layer is redrawn
+	\param [in] width {Width of the client area}
+	\param [in] height {Height of the client area}
+*/
+void resizePaintLayer(int width, int height) {
+	HDC screenDC = GetDC(NULL);
+	HBITMAP layer_bitmap = CreateCompatibleBitmap(screenDC, width > 0 ? width : 1, height > 0 ? height : 1);
+	HBITMAP frame_bitmap = CreateCompatibleBitmap(screenDC, width > 0 ? width : 1, height > 0 ? height : 1);
+
+	if (layerDC == NULL) {
+		layerDC = CreateCompatibleDC(screenDC);
+		Window::MemoryTelemetry::getShared().countResources(Window::MEMORY_RENDERER, 1);
+	}
+
+	SelectObject(layerDC, layer_bitmap);
+
+	if (layerBitmap != NULL) {
+		DeleteObject(layerBitmap);
+	} else {
+		Window::MemoryTelemetry::getShared().countResources(Window::MEMORY_RENDERER, 1);
+	}
+
+	layerBitmap = layer_bitmap;
+	layerWidth = width;
+	layerHeight = height;
+	paintLayer.invalidate();
+
+	std::lock_guard<std::mutex> lock(frameMutex);
+
+	if (frameDC == NULL) {
+		frameDC = CreateCompatibleDC(screenDC);
+		Window::MemoryTelemetry::getShared().countResources(Window::MEMORY_RENDERER, 1);
+	}
+
+	SelectObject(frameDC, frame_bitmap);
+
+	if (frameBitmap != NULL) {
+		DeleteObject(frameBitmap);
+	} else {
+		Window::MemoryTelemetry::getShared().countResources(Window::MEMORY_RENDERER, 1);
+	}
+
+	frameBitmap = frame_bitmap;
+
+	// Shown until the first frame of the new size is rendered
+	RECT frame_rect = { 0, 0, width, height };
+
+	FillRect(frameDC, &frame_rect, GetSysColorBrush(COLOR_WINDOW));
+	GdiFlush();
+	ReleaseDC(NULL, screenDC);
+}
+
+/*!
+	\brief Render the latest snapshot into the frame, paint thread only
+	\details Dirty parts of the layer are redrawn without holding the frame, so WM_PAINT
+		waits only for the copy of the layer and the foreground. Edits made by WndProc
+		while the frame renders are counted in its tracked allocations too.
+	\param [in] width {Width of the client area}
+	\param [in] height {Height of the client area}
+*/
+void renderPaintFrame(int width, int height) {
+	Window::MemoryTelemetry::getShared().beginFrame();
+
+	if (layerDC == NULL || width != layerWidth || height != layerHeight) {
+		resizePaintLayer(width, height);
+	}
+
+	Window::SnapshotGuard snapshot(mainSnapshots, paintReaderSlot);
+	Window::ClipRect viewport = { 0, 0, width, height };
+
+	paintLayer.update(*snapshot, viewport);
+
+	// Dirty parts of the layer are cleared and background figures touching them are drawn again
+	const Window::TrackedVector<Window::ClipRect, Window::MEMORY_RENDERER>& dirty_rects = paintLayer.getDirtyRects();
+
+	if (!dirty_rects.empty()) {
+		HPEN old_layer_pen = (HPEN)SelectObject(layerDC, figurePens[0]);
+
+		for (size_t r = 0; r < dirty_rects.size(); r++) {
+			RECT dirty = { dirty_rects[r].left, dirty_rects[r].top, dirty_rects[r].right, dirty_rects[r].bottom };
+
+			FillRect(layerDC, &dirty, GetSysColorBrush(COLOR_WINDOW));
+		}
+
+		const Window::TrackedVector<int, Window::MEMORY_RENDERER>& dirty_figures = paintLayer.findDirtyFigures(*snapshot);
+
+		for (size_t f = 0; f < dirty_figures.size(); f++) {
+			Window::Figure figure = snapshot->getFigure(dirty_figures[f]);
+
+			drawFigureOutline(layerDC, figure, viewport);
+		}
+
+		SelectObject(layerDC, old_layer_pen);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(frameMutex);
+
+		BitBlt(frameDC, 0, 0, width, height, layerDC, 0, 0, SRCCOPY);
+
+		// Active, selected and highlighted figures are drawn on top every frame
+		const Window::TrackedVector<int, Window::MEMORY_RENDERER>& foreground = paintLayer.getForegroundFigures();
+		HPEN old_pen = (HPEN)SelectObject(frameDC, figurePens[0]);
+
+		for (size_t f = 0; f < foreground.size(); f++) {
+			Window::Figure figure = snapshot->getFigure(foreground[f]);
+
+			SelectObject(frameDC, figurePens[snapshot->getFigureState(foreground[f])]);
+			drawFigureOutline(frameDC, figure, viewport);
+		}
+
+		SelectObject(frameDC, old_pen);
+		// GDI batches calls of the thread, the frame has to be complete before WM_PAINT copies it
+		GdiFlush();
+	}
+
+	Window::MemoryTelemetry::getShared().endFrame();
+}
+
+// Body of the paint thread: render a frame for every batch of requests until the window is closed
+void runPaintThread() {
+	figurePens[0] = CreatePen(PS_SOLID, 1, RGB(255, 0, 0));
+	figurePens[Window::Scene::FIGURE_ACTIVE] = CreatePen(PS_SOLID, 5, RGB(255, 0, 0));
+	figurePens[Window::Scene::FIGURE_SELECTED] = CreatePen(PS_SOLID, 1, RGB(0, 0, 255));
+	figurePens[Window::Scene::FIGURE_ACTIVE | Window::Scene::FIGURE_SELECTED] = CreatePen(PS_SOLID, 5, RGB(0, 0, 255));
+	Window::MemoryTelemetry::getShared().countResources(Window::MEMORY_RENDERER, 4);
+
+	while (true) {
+		int width;
+		int height;
+
+		{
+			std::unique_lock<std::mutex> lock(paintRequestMutex);
+
+			paintRequested.wait(lock, []() { return isPaintRequested || isPaintStopping; });
+
+			if (isPaintStopping) {
+				break;
+			}
+
+			isPaintRequested = false;
+			width = paintWidth;
+			height = paintHeight;
+		}
+
+		renderPaintFrame(width, height);
+		// Posts WM_PAINT, the window thread is never waited for
+		InvalidateRect(paintWindow, NULL, FALSE);
+	}
+
+	for (int p = 0; p < 4; p++) {
+		DeleteObject(figurePens[p]);
+	}
+
+	Window::MemoryTelemetry::getShared().countResources(Window::MEMORY_RENDERER, -4);
+
+	if (layerDC != NULL) {
+		DeleteDC(layerDC);
+		DeleteObject(layerBitmap);
+		DeleteDC(frameDC);
+		DeleteObject(frameBitmap);
+		layerDC = NULL;
+		layerBitmap = NULL;
+		frameDC = NULL;
+		frameBitmap = NULL;
+		Window::MemoryTelemetry::getShared().countResources(Window::MEMORY_RENDERER, -4);
+	}
+}
+
+/*!
+	\brief Ask the paint thread for a frame of the latest published snapshot
+	\param [in] hwnd {The window}
+*/
+void requestPaint(HWND hwnd) {
+	RECT rect;
+
+	GetClientRect(hwnd, &rect);
+
+	{
+		std::lock_guard<std::mutex> lock(paintRequestMutex);
+
+		isPaintRequested = true;
+		paintWidth = (int)rect.right;
+		paintHeight = (int)rect.bottom;
+	}
+
+	paintRequested.notify_one();
+}
+
+// Stop the paint thread, it frees its GDI objects
+void stopPaintThread() {
+	{
+		std::lock_guard<std::mutex> lock(paintRequestMutex);
+
+		isPaintStopping = true;
+	}
+
+	paintRequested.notify_one();
+
+	if (paintThread.joinable()) {
+		paintThread.join();
+	}
+}
+
+/*!
+	\brief Record the input event, apply its commands to the scene and request a frame
+	\details Commands after a failed one are skipped, the error is printed
+	\param [in] hwnd {The window}
+	\param [in] event {The event}
+*/
+void runEvent(HWND hwnd, const Window::InputEvent& event) {
+	Window::SceneCommand commands[Window::MAX_EVENT_COMMANDS];
+	int commands_count = Window::getEventCommands(event, commands);
+
+	if (commands_count == 0) {
+		return;
+	}
+
+	if (inputRecorder != NULL) {
+		try {
+			inputRecorder->record(event);
+		} catch (const std::exception& err) {
+			std::cout << err.what() << std::endl;
+		}
+	}
+
+	try {
+		for (int c = 0; c < commands_count; c++) {
+			Window::applyCommand(mainScene, commands[c]);
+		}
+	} catch (const std::exception& err) {
+		std::cout << err.what() << std::endl;
+	}
+
+	mainSnapshots.publish();
+
+	if (sceneStream != NULL) {
+		sceneStream->flush();
+	}
+
+	requestPaint(hwnd);
+}
+
+LRESULT CALLBACK WndProc(HWND hwnd, UINT Message, WPARAM wParam, LPARAM lParam) {
+	HDC hDC;
+	PAINTSTRUCT ps;
+	RECT rect;
+
+	switch(Message) {
+		case WM_CREATE: {
+			paintWindow = hwnd;
+			paintThread = std::thread(runPaintThread);
+
+			// Viewers connect and drain their queues while the window is idle
+			if (sceneStream != NULL) {
+				SetTimer(hwnd, STREAM_TIMER, 50, NULL);
+			}
+
+			break;
+		}
+
+		case WM_SIZE: {
+			requestPaint(hwnd);
+			break;
+		}
+
+		case WM_TIMER: {
+			if (wParam == STREAM_TIMER && sceneStream != NULL) {
+				sceneStream->flush();
+			}
+
+			break;
+		}
+
+		case WM_DESTROY: {
+			if (inputRecorder != NULL) {
+				try {
+					inputRecorder->finish(mainScene);
+				} catch (const std::exception& err) {
+					std::cout << err.what() << std::endl;
+				}
+
+				delete inputRecorder;
+				inputRecorder = NULL;
+				Window::closeExportFile(inputTraceFile);
+			}
+
+			stopPaintThread();
+
+			if (sceneStream != NULL) {
+				KillTimer(hwnd, STREAM_TIMER);
+				delete sceneStream;
+				sceneStream = NULL;
+			}
+
+			PostQuitMessage(0);
+			break;
+		}
+
+		// The frame covers the whole window, erasing it first would only flicker
+		case WM_ERASEBKGND: {
+			return 1;
+		}
+
+		// Frames are rendered by the paint thread, painting only copies the latest one
+		case WM_PAINT: {
+			hDC = BeginPaint(hwnd, &ps);
+
+			{
+				std::lock_guard<std::mutex> lock(frameMutex);
+
+				if (frameDC != NULL) {
+					BitBlt(
+						hDC,
+						ps.rcPaint.left,
+						ps.rcPaint.top,
+						ps.rcPaint.right - ps.rcPaint.left,
+						ps.rcPaint.bottom - ps.rcPaint.top,
+						frameDC,
+						ps.rcPaint.left,
+						ps.rcPaint.top,
+						SRCCOPY
+					);
+				} else {
+					FillRect(hDC, &ps.rcPaint, GetSysColorBrush(COLOR_WINDOW));
+				}
+			}
+
+			EndPaint(hwnd, &ps);
+			break;
+		}
+
+		case WM_KEYDOWN: {
+			switch (wParam) {
+				case 'S': {
+					GetClientRect(hwnd, &rect);
+
+					try {
+						int fd = Window::openExportFile("scene.svg");
+
+						try {
+							Window::SvgExporter(fd).exportScene(mainScene, rect.right, rect.bottom);
+						} catch (const std::exception& err) {
+							std::cout << err.what() << std::endl;
+						}
+
+						Window::closeExportFile(fd);
+
+						fd = Window::openExportFile("scene.png");
+
+						try {
+							Window::PngExporter(fd).exportScene(mainScene, rect.right, rect.bottom);
+						} catch (const std::exception& err) {
+							std::cout << err.what() << std::endl;
+						}
+
+						Window::closeExportFile(fd);
+					} catch (const std::exception& err) {
+						std::cout << err.what() << std::endl;
+					}
+
+					break;
+				}
+
+				// Memory report of the running window, see --memory
+				case 'M': {
+					Window::MemoryTelemetry::getShared().printReport(stdout);
+					fflush(stdout);
+					break;
+				}
+
+				// Clicks place the figure at the point, at the nearest center or at the nearest vertex
+				case Window::KEY_TAB: {
+					runEvent(hwnd, { Window::INPUT_KEY, (int)wParam });
+					std::cout << "snap: " << Window::snap_mode_names[mainScene.getSnapMode()] << std::endl;
+					break;
+				}
+
+				default: {
+					runEvent(hwnd, { Window::INPUT_KEY, (int)wParam });
+					break;
+				}
+			}
+
+			break;
+		}
+
+		case WM_LBUTTONDOWN: {
+			int mouse_x = LOWORD(lParam);
+			int mouse_y = HIWORD(lParam);
+
+			runEvent(hwnd, { Window::INPUT_LEFT_BUTTON, 0, { mouse_x, mouse_y } });
+			break;
+		}
+
+		// Dragging with the left button places the figure at every step, snapping as clicks do
+		case WM_MOUSEMOVE: {
+			if ((wParam & MK_LBUTTON) == 0 || mainScene.countElements() == 0 || mainScene.isBlocked()) {
+				break;
+			}
+
+			int mouse_x = LOWORD(lParam);
+			int mouse_y = HIWORD(lParam);
+
+			runEvent(hwnd, { Window::INPUT_LEFT_BUTTON, 0, { mouse_x, mouse_y } });
+			break;
+		}
+
+		case WM_MBUTTONDOWN: {
+			runEvent(hwnd, { Window::INPUT_MIDDLE_BUTTON });
+			break;
+		}
+
+		case WM_RBUTTONDOWN: {
+			int mouse_x = LOWORD(lParam);
+			int mouse_y = HIWORD(lParam);
+
+			runEvent(hwnd, { Window::INPUT_RIGHT_BUTTON, 0, { mouse_x, mouse_y } });
+			break;
+		}
+
+		default:
+			return DefWindowProc(hwnd, Message, wParam, lParam);
+	}
+
+	return 0;
+}
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+	WNDCLASSEX wc; 
+	HWND hwnd; 
+	MSG msg; 
+
+	const char* record_path = strstr(lpCmdLine, "--record ");
+
+	if (record_path != NULL) {
+		char path[MAX_PATH] = {};
+
+		sscanf(record_path + 9, "%259s", path);
+
+		try {
+			inputTraceFile = Window::openExportFile(path);
+			inputRecorder = new Window::TraceRecorder(inputTraceFile);
+		} catch (const std::exception& err) {
+			std::cout << err.what() << std::endl;
+		}
+	}
+
+	const char* stream_path = strstr(lpCmdLine, "--stream ");
+
+	if (stream_path != NULL) {
+		char path[MAX_PATH] = {};
+
+		sscanf(stream_path + 9, "%259s", path);
+
+		try {
+			sceneStream = new Window::StreamServer(mainScene, path);
+		} catch (const std::exception& err) {
+			std::cout << err.what() << std::endl;
+		}
+	}
+
+	memset(&wc, 0, sizeof(wc));
+	wc.cbSize = sizeof(WNDCLASSEX);
+	wc.lpfnWndProc = WndProc; 
+	wc.hInstance = hInstance;
+	wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+	wc.hbrBackground = (HBRUSH)(COLOR_WINDOW+1);
+	wc.lpszClassName = "WindowClass";
+	wc.hIcon = LoadIcon(NULL, IDI_APPLICATION);
+	wc.hIconSm = LoadIcon(NULL, IDI_APPLICATION);
+
+	if(!RegisterClassEx(&wc)) {
+		MessageBox(NULL, "Window Registration Failed!", "Error!", MB_ICONEXCLAMATION | MB_OK);
+		return 0;
+	}
+
+	hwnd = CreateWindowEx(WS_EX_CLIENTEDGE, "WindowClass", "Ya verstal", WS_VISIBLE | WS_OVERLAPPEDWINDOW,
+		CW_USEDEFAULT, 
+		CW_USEDEFAULT, 
+		640, 
+		480, 
+		NULL, NULL, hInstance, NULL
+	);
+
+	if(hwnd == NULL) {
+		MessageBox(NULL, "Window Creation Failed!", "Error!", MB_ICONEXCLAMATION | MB_OK);
+		return 0;
+	}
+
+	while(GetMessage(&msg, NULL, 0, 0) > 0) { 
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+	}
+
+	return msg.wParam;
 }
\ No newline at end of file
@@ -0,0 +1,441 @@
+#ifndef PAINTING_NEAREST_H
+#define PAINTING_NEAREST_H
+
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+#include "figure.h"
+
+namespace Window {
+	// Where a click puts the active figure, see Scene::moveActiveFigureNear
+	enum SnapMode {
+		SNAP_OFF,
+		SNAP_TO_CENTER,
+		SNAP_TO_VERTEX,
+		SNAP_MODES,
+	};
+
+	// Names of snap modes, indexed by SnapMode
+	const char* const snap_mode_names[Window::SNAP_MODES] = {
+		"off",
+		"centers",
+		"vertices",
+	};
+
+	/*!
+		\brief Center or vertex of a figure found by the nearest neighbor query
+		\version 1.0.0
+		\author Crinax
+	*/
+	struct NearestPoint {
+		int figure;
+		// Index of the vertex as getVertices gives it, -1 for the center
+		int vertex;
+		Window::Point point;
+		// Squared distance to the queried point
+		double distance;
+	};
+
+	typedef Window::TrackedVector<Window::NearestPoint, Window::MEMORY_NEAREST> NearestList;
+
+	/*!
+		\brief Uniform grid over figure centers for k nearest neighbor queries
+		\details Cells are sized for about two centers each and stored as one sorted array
+			with the start of every cell. A query visits rings of cells around the point and
+			stops once the ring is farther than the k-th best match. Vertices are found
+			through the centers: a vertex is at most the radius away from its center, and
+			figures with radius of more than LARGE_RADIUS_CELLS cells are kept in a list of
+			their own, so they don't widen the search for all others. Moved and new figures
+			are only marked and checked one by one, the grid is rebuilt on the next query
+			when they are more than a sixteenth of all, like OverlapIndex repairs its order.
+		\version 1.0.0
+		\author Crinax
+	*/
+	class NearestIndex {
+		public:
+			// Figures larger than this many cells are not put into the grid
+			static const int LARGE_RADIUS_CELLS = 4;
+
+			NearestIndex() {
+				this->origin_x = 0;
+				this->origin_y = 0;
+				this->cell_size = 1;
+				this->columns = 0;
+				this->rows = 0;
+				this->grid_radius = 0;
+			}
+
+			// Returns number of proxies
+			int countProxies() {
+				return (int)this->proxies.size();
+			}
+
+			// Reserve storage for count proxies
+			void reserve(size_t count) {
+				this->proxies.reserve(count);
+				this->is_moved.reserve(count);
+			}
+
+			/*!
+				\brief Add proxy for the figure appended to the scene
+				\param [in] figure {The new figure}
+			*/
+			void insert(Window::Figure& figure) {
+				this->proxies.push_back(this->makeProxy(figure));
+				this->is_moved.push_back(true);
+				this->moved.push_back((int)this->proxies.size() - 1);
+			}
+
+			/*!
+				\brief Refresh proxy after the figure was moved or scaled
+				\param [in] index {Index of the figure}
+				\param [in] figure {The figure}
+			*/
+			void update(int index, Window::Figure& figure) {
+				this->proxies[index] = this->makeProxy(figure);
+
+				if (!this->is_moved[index]) {
+					this->is_moved[index] = true;
+					this->moved.push_back(index);
+				}
+			}
+
+			/*!
+				\brief Remove proxy of the erased figure, indices after it are shifted down
+				\param [in] index {Index of the figure}
+			*/
+			void erase(int index) {
+				this->proxies.erase(this->proxies.begin() + index);
+				this->is_moved.erase(this->is_moved.begin() + index);
+
+				// Cells keep their starts, the removed figure is left as -1
+				for (size_t i = 0; i < this->cell_figures.size(); i++) {
+					int current = this->cell_figures[i];
+
+					this->cell_figures[i] = current == index ? -1 : current - (current > index ? 1 : 0);
+				}
+
+				this->eraseFrom(this->moved, index);
+				this->eraseFrom(this->large, index);
+			}
+
+			// Remove all proxies
+			void clear() {
+				this->proxies.clear();
+				this->is_moved.clear();
+				this->moved.clear();
+				this->large.clear();
+				this->cell_starts.clear();
+				this->cell_figures.clear();
+				this->columns = 0;
+				this->rows = 0;
+				this->grid_radius = 0;
+			}
+
+			/*!
+				\brief Find k figure centers nearest to the point
+				\param [in] point {The point}
+				\param [in] k {Number of centers}
+				\param [in] accept {Returns false for indices of figures which must not be found}
+				\param [out] result {Up to k centers, the closest first}
+			*/
+			template <typename Filter>
+			void findNearestCenters(Window::Point point, int k, Filter accept, Window::NearestList& result) {
+				this->search(point, k, NULL, accept, result);
+			}
+
+			/*!
+				\brief Find k vertices nearest to the point
+				\param [in] point {The point}
+				\param [in] k {Number of vertices}
+				\param [in] figures {All figures of the scene, in the same order as the proxies}
+				\param [in] accept {Returns false for indices of figures which must not be found}
+				\param [out] result {Up to k vertices, the closest first}
+			*/
+			template <typename Filter>
+			void findNearestVertices(Window::Point point, int k, Window::FigureList& figures, Filter accept, Window::NearestList& result) {
+				this->search(point, k, &figures, accept, result);
+			}
+
+		protected:
+			// Center and radius of one figure
+			struct NearestProxy {
+				Window::Point center;
+				int radius;
+			};
+
+			Window::TrackedVector<NearestProxy, Window::MEMORY_NEAREST> proxies;
+			Window::TrackedVector<bool, Window::MEMORY_NEAREST> is_moved;
+			Window::TrackedVector<int, Window::MEMORY_NEAREST> moved;
+			Window::TrackedVector<int, Window::MEMORY_NEAREST> large;
+			// Figures of cell c are cell_figures[cell_starts[c] .. cell_starts[c + 1])
+			Window::TrackedVector<int, Window::MEMORY_NEAREST> cell_starts;
+			Window::TrackedVector<int, Window::MEMORY_NEAREST> cell_figures;
+			long long origin_x;
+			long long origin_y;
+			long long cell_size;
+			long long columns;
+			long long rows;
+			// Largest radius of figures in the grid
+			int grid_radius;
+
+			// Build proxy from the figure, two pixels are added to cover truncation of vertices
+			NearestProxy makeProxy(Window::Figure& figure) {
+				return { figure.getPosition(), abs(figure.getRadius()) + 2 };
+			}
+
+			void eraseFrom(Window::TrackedVector<int, Window::MEMORY_NEAREST>& list, int index) {
+				size_t kept = 0;
+
+				for (size_t i = 0; i < list.size(); i++) {
+					if (list[i] != index) {
+						list[kept++] = list[i] > index ? list[i] - 1 : list[i];
+					}
+				}
+
+				list.resize(kept);
+			}
+
+			// Returns floor of value / divisor for positive divisor
+			long long floorDiv(long long value, long long divisor) {
+				return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+			}
+
+			// Put every proxy into its cell again
+			void rebuild() {
+				int count = (int)this->proxies.size();
+
+				this->moved.clear();
+				this->large.clear();
+				this->is_moved.assign(count, false);
+				this->grid_radius = 0;
+
+				if (count == 0) {
+					this->columns = 0;
+					this->rows = 0;
+					this->cell_starts.clear();
+					this->cell_figures.clear();
+					return;
+				}
+
+				long long min_x = this->proxies[0].center.x;
+				long long min_y = this->proxies[0].center.y;
+				long long max_x = min_x;
+				long long max_y = min_y;
+
+				for (int i = 1; i < count; i++) {
+					min_x = std::min(min_x, (long long)this->proxies[i].center.x);
+					min_y = std::min(min_y, (long long)this->proxies[i].center.y);
+					max_x = std::max(max_x, (long long)this->proxies[i].center.x);
+					max_y = std::max(max_y, (long long)this->proxies[i].center.y);
+				}
+
+				double width = (double)(max_x - min_x + 1);
+				double height = (double)(max_y - min_y + 1);
+				// About two centers per cell, never more cells than four per figure
+				double cell = std::max(sqrt(width * height * 2 / count), 4.0);
+
+				while ((floor(width / cell) + 1) * (floor(height / cell) + 1) > 4.0 * count + 16) {
+					cell *= 2;
+				}
+
+				this->origin_x = min_x;
+				this->origin_y = min_y;
+				this->cell_size = (long long)ceil(cell);
+				this->columns = (max_x - min_x) / this->cell_size + 1;
+				this->rows = (max_y - min_y) / this->cell_size + 1;
+				this->cell_starts.assign(this->columns * this->rows + 1, 0);
+
+				long long large_radius = this->cell_size * Window::NearestIndex::LARGE_RADIUS_CELLS;
+
+				for (int i = 0; i < count; i++) {
+					if (this->proxies[i].radius > large_radius) {
+						this->large.push_back(i);
+						continue;
+					}
+
+					this->grid_radius = std::max(this->grid_radius, this->proxies[i].radius);
+					this->cell_starts[this->cellOf(this->proxies[i].center) + 1]++;
+				}
+
+				for (size_t c = 1; c < this->cell_starts.size(); c++) {
+					this->cell_starts[c] += this->cell_starts[c - 1];
+				}
+
+				// Starts are moved one cell forward while filling and come back to their places
+				this->cell_figures.resize(count - this->large.size());
+
+				for (int i = 0; i < count; i++) {
+					if (this->proxies[i].radius <= large_radius) {
+						this->cell_figures[this->cell_starts[this->cellOf(this->proxies[i].center)]++] = i;
+					}
+				}
+
+				for (size_t c = this->cell_starts.size() - 1; c > 0; c--) {
+					this->cell_starts[c] = this->cell_starts[c - 1];
+				}
+
+				this->cell_starts[0] = 0;
+			}
+
+			long long cellOf(Window::Point center) {
+				return (center.y - this->origin_y) / this->cell_size * this->columns + (center.x - this->origin_x) / this->cell_size;
+			}
+
+			// Order of matches, ties are broken by indices so results don't depend on the grid
+			static bool isCloser(const Window::NearestPoint& a, const Window::NearestPoint& b) {
+				if (a.distance != b.distance) {
+					return a.distance < b.distance;
+				}
+
+				if (a.figure != b.figure) {
+					return a.figure < b.figure;
+				}
+
+				return a.vertex < b.vertex;
+			}
+
+			// Keep the match if it is among the k best, result is a heap with the worst match on top
+			void offer(const Window::NearestPoint& match, int k, Window::NearestList& result) {
+				if ((int)result.size() < k) {
+					result.push_back(match);
+					std::push_heap(result.begin(), result.end(), Window::NearestIndex::isCloser);
+					return;
+				}
+
+				if (!Window::NearestIndex::isCloser(match, result.front())) {
+					return;
+				}
+
+				std::pop_heap(result.begin(), result.end(), Window::NearestIndex::isCloser);
+				result.back() = match;
+				std::push_heap(result.begin(), result.end(), Window::NearestIndex::isCloser);
+			}
+
+			// Returns true if nothing at the distance can be among the k best
+			bool isBeyond(double distance, int k, Window::NearestList& result) {
+				return distance > 0 && (int)result.size() == k && distance * distance > result.front().distance;
+			}
+
+			double distanceOf(Window::Point a, Window::Point b) {
+				double dx = (double)a.x - b.x;
+				double dy = (double)a.y - b.y;
+
+				return dx * dx + dy * dy;
+			}
+
+			// Offer the center or the vertices of the figure
+			template <typename Filter>
+			void visit(int index, Window::Point point, int k, Window::FigureList* figures, Filter& accept, Window::NearestList& result) {
+				const NearestProxy& proxy = this->proxies[index];
+				double distance = this->distanceOf(proxy.center, point);
+
+				if (figures == NULL) {
+					if (accept(index)) {
+						this->offer({ index, -1, proxy.center, distance }, k, result);
+					}
+
+					return;
+				}
+
+				if (this->isBeyond(sqrt(distance) - proxy.radius, k, result) || !accept(index) || !(*figures)[index]->is_initialized) {
+					return;
+				}
+
+				Window::Point vertices[Window::Figure::MAX_VERTICES];
+				int vertices_count = (*figures)[index]->getVertices(vertices);
+
+				for (int v = 0; v < vertices_count; v++) {
+					this->offer({ index, v, vertices[v], this->distanceOf(vertices[v], point) }, k, result);
+				}
+			}
+
+			template <typename Filter>
+			void search(Window::Point point, int k, Window::FigureList* figures, Filter& accept, Window::NearestList& result) {
+				if (this->moved.size() * 16 > this->proxies.size() + 1024) {
+					this->rebuild();
+				}
+
+				result.clear();
+
+				if (k <= 0) {
+					return;
+				}
+
+				for (size_t i = 0; i < this->moved.size(); i++) {
+					this->visit(this->moved[i], point, k, figures, accept, result);
+				}
+
+				for (size_t i = 0; i < this->large.size(); i++) {
+					if (!this->is_moved[this->large[i]]) {
+						this->visit(this->large[i], point, k, figures, accept, result);
+					}
+				}
+
+				if (this->columns > 0) {
+					this->searchGrid(point, k, figures, accept, result);
+				}
+
+				std::sort_heap(result.begin(), result.end(), Window::NearestIndex::isCloser);
+			}
+
+			template <typename Filter>
+			void visitCell(long long cell, Window::Point point, int k, Window::FigureList* figures, Filter& accept, Window::NearestList& result) {
+				for (int e = this->cell_starts[cell]; e < this->cell_starts[cell + 1]; e++) {
+					int index = this->cell_figures[e];
+
+					if (index >= 0 && !this->is_moved[index]) {
+						this->visit(index, point, k, figures, accept, result);
+					}
+				}
+			}
+
+			// Visit rings of cells around the point until they are farther than the k-th match
+			template <typename Filter>
+			void searchGrid(Window::Point point, int k, Window::FigureList* figures, Filter& accept, Window::NearestList& result) {
+				// Cell of the point, which may be outside of the grid
+				long long x = this->floorDiv(point.x - this->origin_x, this->cell_size);
+				long long y = this->floorDiv(point.y - this->origin_y, this->cell_size);
+				long long first_ring = std::max(std::max(-x, x - (this->columns - 1)), std::max(-y, y - (this->rows - 1)));
+				double reach = figures != NULL ? this->grid_radius : 0;
+
+				for (long long ring = std::max(first_ring, 0LL); ; ring++) {
+					if (this->isBeyond((double)(ring - 1) * this->cell_size - reach, k, result)) {
+						return;
+					}
+
+					long long top = std::max(y - ring, 0LL);
+					long long bottom = std::min(y + ring, this->rows - 1);
+					long long left = std::max(x - ring, 0LL);
+					long long right = std::min(x + ring, this->columns - 1);
+
+					for (long long row = top; row <= bottom; row++) {
+						// Inner rows of the ring have only its left and right cells
+						if (row != y - ring && row != y + ring) {
+							if (x - ring >= 0) {
+								this->visitCell(row * this->columns + x - ring, point, k, figures, accept, result);
+							}
+
+							if (ring > 0 && x + ring < this->columns) {
+								this->visitCell(row * this->columns + x + ring, point, k, figures, accept, result);
+							}
+
+							continue;
+						}
+
+						for (long long column = left; column <= right; column++) {
+							this->visitCell(row * this->columns + column, point, k, figures, accept, result);
+						}
+					}
+
+					// The ring covers the whole grid
+					if (x - ring <= 0 && y - ring <= 0 && x + ring >= this->columns - 1 && y + ring >= this->rows - 1) {
+						return;
+					}
+				}
+			}
+	};
+};
+
+#endif
@@ -0,0 +1,458 @@
+#ifndef PAINTING_OVERLAP_H
+#define PAINTING_OVERLAP_H
+
+#include <stdlib.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "figure.h"
+
+namespace Window {
+	/*!
+		\brief Bounding box and circle of one figure used by the broadphase
+		\version 1.0.0
+		\author Crinax
+	*/
+	struct OverlapProxy {
+		int min_x;
+		int max_x;
+		int min_y;
+		int max_y;
+		Window::Point center;
+		int radius;
+	};
+
+	// Proxy box in one horizontal band of the sweep, copied so the broadphase scan stays sequential
+	struct OverlapEntry {
+		int band;
+		int min_x;
+		int max_x;
+		int min_y;
+		int max_y;
+		int proxy;
+	};
+
+	typedef Window::TrackedVector<Window::OverlapEntry, Window::MEMORY_OVERLAPS> OverlapEntryList;
+
+	/*!
+		\brief Separating axis test for two convex polygons
+		\details Touching polygons are treated as overlapping. Polygons with less than
+			two vertices give no axes, so only the axes of the other polygon are tested.
+			A polygon without vertices overlaps nothing.
+		\param [in] a {Vertices of the first polygon}
+		\param [in] a_count {Number of vertices of the first polygon}
+		\param [in] b {Vertices of the second polygon}
+		\param [in] b_count {Number of vertices of the second polygon}
+	*/
+	inline bool polygonsOverlap(const Window::Point* a, int a_count, const Window::Point* b, int b_count) {
+		if (a_count <= 0 || b_count <= 0) {
+			return false;
+		}
+
+		const Window::Point* polygons[2] = { a, b };
+		int counts[2] = { a_count, b_count };
+
+		for (int p = 0; p < 2; p++) {
+			const Window::Point* polygon = polygons[p];
+			int count = counts[p];
+
+			if (count < 2) {
+				continue;
+			}
+
+			for (int i = 0; i < count; i++) {
+				Window::Point from = polygon[i];
+				Window::Point to = polygon[(i + 1) % count];
+
+				// Normal of the edge, integer coords keep the projections exact
+				long long axis_x = -(long long)(to.y - from.y);
+				long long axis_y = (long long)(to.x - from.x);
+
+				if (axis_x == 0 && axis_y == 0) {
+					continue;
+				}
+
+				long long a_min = axis_x * a[0].x + axis_y * a[0].y;
+				long long a_max = a_min;
+
+				for (int j = 1; j < a_count; j++) {
+					long long projection = axis_x * a[j].x + axis_y * a[j].y;
+					a_min = std::min(a_min, projection);
+					a_max = std::max(a_max, projection);
+				}
+
+				long long b_min = axis_x * b[0].x + axis_y * b[0].y;
+				long long b_max = b_min;
+
+				for (int j = 1; j < b_count; j++) {
+					long long projection = axis_x * b[j].x + axis_y * b[j].y;
+					b_min = std::min(b_min, projection);
+					b_max = std::max(b_max, projection);
+				}
+
+				if (a_max < b_min || b_max < a_min) {
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	/*!
+		\brief Incremental overlap index for figures of the scene
+		\details Broadphase is sweep-and-prune over the x extents of bounding circles,
+			done separately in horizontal bands at least as high as the largest figure,
+			so a figure lies in one or two bands and only meets its neighbours in the sweep.
+			Narrowphase is the separating axis test on figure vertices. Proxies are
+			indexed like figures of the scene. Moved figures are only marked, the
+			sorted order is repaired on the next query by merging the moved entries
+			back, so a query after k moves costs O(n + k log k) instead of a full sort.
+		\version 1.0.0
+		\author Crinax
+	*/
+	class OverlapIndex {
+		public:
+			OverlapIndex() {
+				this->max_width = 0;
+				this->band_height = 0;
+				this->needs_rebuild = false;
+			}
+
+			// Returns number of proxies
+			int countProxies() {
+				return (int)this->proxies.size();
+			}
+
+			// Reserve storage for count proxies
+			void reserve(size_t count) {
+				this->proxies.reserve(count);
+				this->is_moved.reserve(count);
+			}
+
+			/*!
+				\brief Add proxy for the figure appended to the scene
+				\param [in] figure {The new figure}
+			*/
+			void insert(Window::Figure& figure) {
+				this->proxies.push_back(this->makeProxy(figure));
+				this->is_moved.push_back(true);
+				this->moved.push_back((int)this->proxies.size() - 1);
+
+				this->growWidth(this->proxies.back());
+			}
+
+			/*!
+				\brief Refresh proxy after the figure was moved or scaled
+				\param [in] index {Index of the figure}
+				\param [in] figure {The figure}
+			*/
+			void update(int index, Window::Figure& figure) {
+				this->proxies[index] = this->makeProxy(figure);
+				this->growWidth(this->proxies[index]);
+
+				if (!this->is_moved[index]) {
+					this->is_moved[index] = true;
+					this->moved.push_back(index);
+				}
+
+			}
+
+			/*!
+				\brief Remove proxy of the erased figure, indices after it are shifted down
+				\param [in] index {Index of the figure}
+			*/
+			void erase(int index) {
+				this->proxies.erase(this->proxies.begin() + index);
+				this->is_moved.erase(this->is_moved.begin() + index);
+
+				// Removing entries keeps the order sorted, only indices have to be shifted
+				size_t kept = 0;
+
+				for (size_t i = 0; i < this->entries.size(); i++) {
+					OverlapEntry entry = this->entries[i];
+
+					if (entry.proxy != index) {
+						entry.proxy -= entry.proxy > index ? 1 : 0;
+						this->entries[kept++] = entry;
+					}
+				}
+
+				this->entries.resize(kept);
+
+				kept = 0;
+
+				for (size_t i = 0; i < this->moved.size(); i++) {
+					int current = this->moved[i];
+
+					if (current != index) {
+						this->moved[kept++] = current > index ? current - 1 : current;
+					}
+				}
+
+				this->moved.resize(kept);
+			}
+
+			// Remove all proxies
+			void clear() {
+				this->proxies.clear();
+				this->is_moved.clear();
+				this->entries.clear();
+				this->moved.clear();
+				this->max_width = 0;
+				this->band_height = 0;
+				this->needs_rebuild = false;
+			}
+
+			/*!
+				\brief Recreate all proxies from the figures, next query sorts them from scratch
+				\param [in] figures {All figures of the scene}
+			*/
+			void rebuild(Window::FigureList& figures) {
+				this->clear();
+				this->proxies.reserve(figures.size());
+
+				for (size_t i = 0; i < figures.size(); i++) {
+					this->proxies.push_back(this->makeProxy(*figures[i]));
+				}
+
+				this->is_moved.assign(this->proxies.size(), false);
+				this->needs_rebuild = true;
+			}
+
+			/*!
+				\brief Enumerate all overlapping pairs of figures
+				\param [in] figures {All figures of the scene, in the same order as the proxies}
+				\param [out] pairs {Pairs of indices (lower, higher), cleared before filling}
+			*/
+			void findOverlappingPairs(Window::FigureList& figures, std::vector<std::pair<int, int>>& pairs) {
+				this->repairOrder();
+
+				pairs.clear();
+
+				int count = (int)this->entries.size();
+				const OverlapEntry* boxes = this->entries.data();
+
+				for (int a = 0; a < count; a++) {
+					const OverlapEntry first = boxes[a];
+
+					for (int b = a + 1; b < count && boxes[b].band == first.band && boxes[b].min_x <= first.max_x; b++) {
+						if (boxes[b].max_y < first.min_y || first.max_y < boxes[b].min_y) {
+							continue;
+						}
+
+						// Pair shared by two bands is reported only in the band of its top row
+						if (this->bandOf(std::max(first.min_y, boxes[b].min_y)) != first.band) {
+							continue;
+						}
+
+						if (!this->circlesOverlap(first, boxes[b])) {
+							continue;
+						}
+
+						int i = first.proxy;
+						int j = boxes[b].proxy;
+
+						if (this->verticesOverlap(i, j, figures)) {
+							pairs.push_back(i < j ? std::make_pair(i, j) : std::make_pair(j, i));
+						}
+					}
+				}
+			}
+
+			/*!
+				\brief Enumerate figures that overlap one figure
+				\param [in] index {Index of the figure}
+				\param [in] figures {All figures of the scene, in the same order as the proxies}
+				\param [out] result {Indices of overlapping figures, cleared before filling}
+			*/
+			void findOverlapsOf(int index, Window::FigureList& figures, std::vector<int>& result) {
+				this->repairOrder();
+
+				result.clear();
+
+				const OverlapProxy& proxy = this->proxies[index];
+				OverlapEntry target = { 0, proxy.min_x, proxy.max_x, proxy.min_y, proxy.max_y, index };
+				int first_band = this->bandOf(target.min_y);
+				int last_band = this->bandOf(target.max_y);
+				int count = (int)this->entries.size();
+
+				for (int band = first_band; band <= last_band; band++) {
+					// Any candidate starts no earlier than max_width before the target
+					OverlapEntry from = { band, target.min_x - this->max_width, 0, 0, 0, 0 };
+					int b = (int)(std::lower_bound(
+						this->entries.begin(),
+						this->entries.end(),
+						from,
+						[](const OverlapEntry& box, const OverlapEntry& value) {
+							return box.band < value.band || (box.band == value.band && box.min_x < value.min_x);
+						}
+					) - this->entries.begin());
+
+					for (; b < count && this->entries[b].band == band && this->entries[b].min_x <= target.max_x; b++) {
+						const OverlapEntry& box = this->entries[b];
+						int j = box.proxy;
+
+						if (j == index || box.max_y < target.min_y || target.max_y < box.min_y) {
+							continue;
+						}
+
+						if (this->bandOf(std::max(target.min_y, box.min_y)) != band || !this->circlesOverlap(target, box)) {
+							continue;
+						}
+
+						if (this->verticesOverlap(index, j, figures)) {
+							result.push_back(j);
+						}
+					}
+				}
+			}
+
+		protected:
+			Window::TrackedVector<Window::OverlapProxy, Window::MEMORY_OVERLAPS> proxies;
+			Window::OverlapEntryList entries;
+			Window::TrackedVector<int, Window::MEMORY_OVERLAPS> moved;
+			Window::TrackedVector<bool, Window::MEMORY_OVERLAPS> is_moved;
+			int max_width;
+			int band_height;
+			bool needs_rebuild;
+
+			// Build proxy from the figure, one pixel is added to cover rounding of vertices
+			OverlapProxy makeProxy(Window::Figure& figure) {
+				Window::Point center = figure.getPosition();
+				int radius = abs(figure.getRadius()) + 1;
+
+				return {
+					center.x - radius,
+					center.x + radius,
+					center.y - radius,
+					center.y + radius,
+					center,
+					radius,
+				};
+			}
+
+			// Track the largest figure, bands lower than it would need a full rebuild
+			void growWidth(const OverlapProxy& proxy) {
+				this->max_width = std::max(this->max_width, proxy.max_x - proxy.min_x);
+
+				if (this->max_width > this->band_height) {
+					this->needs_rebuild = true;
+				}
+			}
+
+			// Returns band of the row, rounding down for negative coords
+			int bandOf(int y) {
+				if (y >= 0) {
+					return y / this->band_height;
+				}
+
+				return -((-y + this->band_height - 1) / this->band_height);
+			}
+
+			bool entryLess(const OverlapEntry& a, const OverlapEntry& b) {
+				if (a.band != b.band) {
+					return a.band < b.band;
+				}
+
+				return a.min_x < b.min_x;
+			}
+
+			// Add entries of the proxy for every band it crosses
+			void appendEntries(int proxy) {
+				const OverlapProxy& box = this->proxies[proxy];
+				int first_band = this->bandOf(box.min_y);
+				int last_band = this->bandOf(box.max_y);
+
+				for (int band = first_band; band <= last_band; band++) {
+					this->entries.push_back({ band, box.min_x, box.max_x, box.min_y, box.max_y, proxy });
+				}
+			}
+
+			void sortEntries(Window::OverlapEntryList::iterator begin, Window::OverlapEntryList::iterator end) {
+				std::sort(begin, end, [this](const OverlapEntry& a, const OverlapEntry& b) {
+					return this->entryLess(a, b);
+				});
+			}
+
+			// Restore sorting of the entries by band and min_x
+			void repairOrder() {
+				// Too many moved proxies, full sort is cheaper than the merge
+				if (this->needs_rebuild || this->moved.size() * 8 > this->proxies.size()) {
+					this->max_width = 0;
+
+					for (size_t i = 0; i < this->proxies.size(); i++) {
+						this->max_width = std::max(this->max_width, this->proxies[i].max_x - this->proxies[i].min_x);
+						this->is_moved[i] = false;
+					}
+
+					// Band twice as high as the largest figure, so every figure lies in at most two bands
+					this->band_height = std::max(2 * this->max_width, 16);
+					this->entries.clear();
+					this->entries.reserve(this->proxies.size() * 2);
+
+					for (size_t i = 0; i < this->proxies.size(); i++) {
+						this->appendEntries((int)i);
+					}
+
+					this->sortEntries(this->entries.begin(), this->entries.end());
+					this->moved.clear();
+					this->needs_rebuild = false;
+
+					return;
+				}
+
+				if (this->moved.empty()) {
+					return;
+				}
+
+				size_t kept = 0;
+
+				for (size_t i = 0; i < this->entries.size(); i++) {
+					if (!this->is_moved[this->entries[i].proxy]) {
+						this->entries[kept++] = this->entries[i];
+					}
+				}
+
+				this->entries.resize(kept);
+
+				for (size_t i = 0; i < this->moved.size(); i++) {
+					this->is_moved[this->moved[i]] = false;
+					this->appendEntries(this->moved[i]);
+				}
+
+				Window::OverlapEntryList::iterator middle = this->entries.begin() + kept;
+				this->sortEntries(middle, this->entries.end());
+				std::inplace_merge(
+					this->entries.begin(),
+					middle,
+					this->entries.end(),
+					[this](const OverlapEntry& a, const OverlapEntry& b) { return this->entryLess(a, b); }
+				);
+
+				this->moved.clear();
+			}
+
+			// Bounding circles test, entries are squares around the circles so center and radius are recovered from them
+			bool circlesOverlap(const OverlapEntry& a, const OverlapEntry& b) {
+				long long dx = ((long long)a.min_x + a.max_x) - ((long long)b.min_x + b.max_x);
+				long long dy = ((long long)a.min_y + a.max_y) - ((long long)b.min_y + b.max_y);
+				long long distance = ((long long)a.max_x - a.min_x) + ((long long)b.max_x - b.min_x);
+
+				return dx * dx + dy * dy <= distance * distance;
+			}
+
+			// Narrowphase for a pair
+			bool verticesOverlap(int i, int j, Window::FigureList& figures) {
+				Window::Point a[Window::Figure::MAX_VERTICES];
+				Window::Point b[Window::Figure::MAX_VERTICES];
+				int a_count = figures[i]->getVertices(a);
+				int b_count = figures[j]->getVertices(b);
+
+				return Window::polygonsOverlap(a, a_count, b, b_count);
+			}
+	};
+};
+
+#endif
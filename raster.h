@@ -0,0 +1,273 @@
+#ifndef PAINTING_RASTER_H
+#define PAINTING_RASTER_H
+
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "figure.h"
+#include "clip.h"
+
+namespace Window {
+	// RGB color of the software renderer
+	struct Color {
+		unsigned char r;
+		unsigned char g;
+		unsigned char b;
+	};
+
+	// Pen of the software renderer, same meaning as in CreatePen
+	struct Pen {
+		Window::Color color;
+		int width;
+	};
+
+	const Window::Color background_color = { 255, 255, 255 };
+
+	/*!
+		\brief Returns pen for the figure, the same as WM_PAINT uses
+		\param [in] is_active {Figure is active}
+		\param [in] is_selected {Figure is selected}
+	*/
+	inline Pen getFigurePen(bool is_active, bool is_selected) {
+		Window::Color color = is_selected ? Window::Color{ 0, 0, 255 } : Window::Color{ 255, 0, 0 };
+
+		return { color, is_active ? 5 : 1 };
+	}
+
+	/*!
+		\brief RGB pixel buffer for the software renderer
+		\details The buffer may be a tile of a larger image, its origin is the window
+			coord of the top left pixel and everything outside the tile is clipped.
+			Drawing may be limited further to a rectangle of the buffer, see setClip.
+		\version 1.2.0
+		\author Crinax
+	*/
+	class Framebuffer {
+		public:
+			/*!
+				\brief Main constructor for class
+				\param [in] width {Width of the buffer in pixels}
+				\param [in] height {Height of the buffer in pixels}
+			*/
+			Framebuffer(int width, int height) {
+				this->width = 0;
+				this->height = 0;
+				this->origin = { 0, 0 };
+
+				this->resize(width, height);
+			}
+
+			/*!
+				\brief Change size of the buffer, contents are undefined after it
+				\param [in] width {Width of the buffer in pixels}
+				\param [in] height {Height of the buffer in pixels}
+			*/
+			void resize(int width, int height) {
+				this->width = std::max(width, 0);
+				this->height = std::max(height, 0);
+
+				this->pixels.resize((size_t)this->width * this->height * 3);
+				this->resetClip();
+			}
+
+			/*!
+				\brief Set window coord of the top left pixel
+				\param [in] origin {Coords of the top left pixel}
+			*/
+			void setOrigin(Window::Point origin) {
+				this->origin = origin;
+				this->resetClip();
+			}
+
+			/*!
+				\brief Limit drawing and fillClip to the rectangle
+				\param [in] rect {Window coords, cut to the buffer}
+			*/
+			void setClip(Window::ClipRect rect) {
+				this->clip = {
+					std::max(rect.left, this->origin.x),
+					std::max(rect.top, this->origin.y),
+					std::min(rect.right, this->origin.x + this->width),
+					std::min(rect.bottom, this->origin.y + this->height),
+				};
+
+				this->clip.right = std::max(this->clip.right, this->clip.left);
+				this->clip.bottom = std::max(this->clip.bottom, this->clip.top);
+			}
+
+			// Draw in the whole buffer again
+			void resetClip() {
+				this->clip = { this->origin.x, this->origin.y, this->origin.x + this->width, this->origin.y + this->height };
+			}
+
+			Window::Point getOrigin() {
+				return this->origin;
+			}
+
+			int getWidth() {
+				return this->width;
+			}
+
+			int getHeight() {
+				return this->height;
+			}
+
+			// Returns pointer to the row of the buffer, 3 bytes per pixel
+			unsigned char* getRow(int y) {
+				return this->pixels.data() + (size_t)y * this->width * 3;
+			}
+
+			// Fill the whole buffer with the color
+			void clear(Window::Color color) {
+				for (size_t i = 0; i < this->pixels.size(); i += 3) {
+					this->pixels[i] = color.r;
+					this->pixels[i + 1] = color.g;
+					this->pixels[i + 2] = color.b;
+				}
+			}
+
+			// Fill the clip rectangle with the color
+			void fillClip(Window::Color color) {
+				for (int y = this->clip.top; y < this->clip.bottom; y++) {
+					unsigned char* pixel = this->getRow(y - this->origin.y) + (this->clip.left - this->origin.x) * 3;
+
+					for (int x = this->clip.left; x < this->clip.right; x++) {
+						pixel[0] = color.r;
+						pixel[1] = color.g;
+						pixel[2] = color.b;
+						pixel += 3;
+					}
+				}
+			}
+
+			/*!
+				\brief Copy pixels of the buffer of the same size
+				\param [in] other {The buffer}
+			*/
+			void copyFrom(Window::Framebuffer& other) {
+				if (other.width != this->width || other.height != this->height) {
+					throw std::runtime_error("[ERR] Window::Framebuffer: sizes of buffers differ");
+				}
+
+				std::copy(other.pixels.begin(), other.pixels.end(), this->pixels.begin());
+			}
+
+			/*!
+				\brief Returns true if the figure may leave pixels in the buffer
+				\param [in] figure {The figure}
+				\param [in] pen {Pen of the figure}
+			*/
+			bool touchesFigure(Window::Figure& figure, Window::Pen pen) {
+				return Window::classifyFigure(figure, this->getClipRect(), pen.width / 2 + 1) != Window::CLIP_OUTSIDE;
+			}
+
+			// Returns window coords where drawing is allowed, the whole buffer unless setClip was called
+			Window::ClipRect getClipRect() {
+				return this->clip;
+			}
+
+			/*!
+				\brief Draw the outline of the figure
+				\details Outlines crossing the border are clipped first, see clipFigure
+				\param [in] figure {The figure}
+				\param [in] pen {Pen of the outline}
+			*/
+			void drawFigure(Window::Figure& figure, Window::Pen pen) {
+				Window::ClipSegment segments[Window::Figure::MAX_VERTICES];
+				int segment_count = Window::clipFigure(figure, this->getClipRect(), pen.width / 2 + 1, segments);
+
+				for (int s = 0; s < segment_count; s++) {
+					this->drawLine(segments[s].from, segments[s].to, pen);
+				}
+			}
+
+			/*!
+				\brief Draw the line, only the part inside the buffer is walked
+				\param [in] from {First point of the line}
+				\param [in] to {Last point of the line}
+				\param [in] pen {Pen of the line}
+			*/
+			void drawLine(Window::Point from, Window::Point to, Window::Pen pen) {
+				int half = pen.width / 2;
+				long long dx = (long long)to.x - from.x;
+				long long dy = (long long)to.y - from.y;
+				long long steps = std::max(llabs(dx), llabs(dy));
+
+				if (steps == 0) {
+					this->stamp(from.x, from.y, pen.color, half);
+					return;
+				}
+
+				// Range of steps where the line is inside the buffer grown by the pen
+				double first = 0;
+				double last = (double)steps;
+
+				this->clipRange(from.x, dx, steps, this->clip.left - half, this->clip.right - 1 + half, first, last);
+				this->clipRange(from.y, dy, steps, this->clip.top - half, this->clip.bottom - 1 + half, first, last);
+
+				if (first > last) {
+					return;
+				}
+
+				long long begin = std::max(0LL, (long long)floor(first) - 1);
+				long long end = std::min(steps, (long long)ceil(last) + 1);
+
+				for (long long i = begin; i <= end; i++) {
+					int x = (int)(from.x + llround((double)dx * i / steps));
+					int y = (int)(from.y + llround((double)dy * i / steps));
+
+					this->stamp(x, y, pen.color, half);
+				}
+			}
+
+		protected:
+			Window::TrackedVector<unsigned char, Window::MEMORY_RENDERER> pixels;
+			int width;
+			int height;
+			Window::Point origin;
+			Window::ClipRect clip;
+
+			// Narrow [first, last] to steps where start + delta * i / steps rounds into [low, high]
+			void clipRange(int start, long long delta, long long steps, int low, int high, double& first, double& last) {
+				if (delta == 0) {
+					if (start < low || start > high) {
+						first = 1;
+						last = 0;
+					}
+
+					return;
+				}
+
+				// Half a pixel of rounding on the minor axis may be many steps
+				double a = ((double)low - 0.5 - start) * steps / delta;
+				double b = ((double)high + 0.5 - start) * steps / delta;
+
+				first = std::max(first, std::min(a, b));
+				last = std::min(last, std::max(a, b));
+			}
+
+			// Paint square of the pen around the pixel
+			void stamp(int x, int y, Window::Color color, int half) {
+				int left = std::max(x - half, this->clip.left) - this->origin.x;
+				int right = std::min(x + half, this->clip.right - 1) - this->origin.x;
+				int top = std::max(y - half, this->clip.top) - this->origin.y;
+				int bottom = std::min(y + half, this->clip.bottom - 1) - this->origin.y;
+
+				for (int row = top; row <= bottom; row++) {
+					unsigned char* pixel = this->getRow(row) + left * 3;
+
+					for (int column = left; column <= right; column++) {
+						pixel[0] = color.r;
+						pixel[1] = color.g;
+						pixel[2] = color.b;
+						pixel += 3;
+					}
+				}
+			}
+	};
+};
+
+#endif
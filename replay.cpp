@@ -0,0 +1,176 @@
+/*!
+	\file
+	\brief Replays input traces recorded by the window (main.cpp --record <trace>)
+	\details Events are applied to a new scene as fast as possible or, with --paced, at
+		the recorded times. Prints latency of events and checks the hash of the final
+		scene against the one in the trace, the exit code is 1 if they differ.
+
+		replay [--paced] [--slowest N] trace
+
+		Build without the window: g++ -std=c++17 -O2 -pthread replay.cpp -o replay
+	\author Crinax
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "scene.h"
+#include "commands.h"
+#include "trace.h"
+
+// Latency of one replayed event
+struct EventLatency {
+	double ns;
+	size_t index;
+};
+
+// Returns the latency below which the part of events is, latencies are sorted
+double percentile(const std::vector<EventLatency>& sorted, double part) {
+	if (sorted.empty()) {
+		return 0;
+	}
+
+	size_t index = (size_t)(part * (sorted.size() - 1) + 0.5);
+
+	return sorted[index].ns;
+}
+
+// Print the event as a command of the script, see Window::parseCommand
+void printEvent(const Window::InputEvent& event) {
+	Window::SceneCommand commands[Window::MAX_EVENT_COMMANDS];
+	int commands_count = Window::getEventCommands(event, commands);
+
+	if (event.type == Window::INPUT_KEY) {
+		printf("key 0x%02x", event.key);
+	} else {
+		printf("button %d at %d,%d", (int)event.type - Window::INPUT_LEFT_BUTTON + 1, event.point.x, event.point.y);
+	}
+
+	for (int c = 0; c < commands_count; c++) {
+		printf(c == 0 ? " (%s" : ", %s", Window::command_names[commands[c].type]);
+	}
+
+	printf(commands_count > 0 ? ")" : " (ignored)");
+}
+
+int main(int argc, char** argv) {
+	bool is_paced = false;
+	int slowest = 5;
+	const char* path = NULL;
+
+	for (int a = 1; a < argc; a++) {
+		if (strcmp(argv[a], "--paced") == 0) {
+			is_paced = true;
+		} else if (strcmp(argv[a], "--slowest") == 0 && a + 1 < argc) {
+			slowest = atoi(argv[++a]);
+		} else if (argv[a][0] == '-') {
+			path = NULL;
+			break;
+		} else {
+			path = argv[a];
+		}
+	}
+
+	if (path == NULL) {
+		fprintf(stderr, "usage: %s [--paced] [--slowest N] trace\n", argv[0]);
+		return 2;
+	}
+
+	try {
+		Window::TraceReader trace(path);
+		const std::vector<Window::TraceEvent>& events = trace.getEvents();
+		Window::Scene scene;
+		std::vector<EventLatency> latencies;
+		long long errors = 0;
+
+		latencies.reserve(events.size());
+
+		std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+		for (size_t e = 0; e < events.size(); e++) {
+			Window::SceneCommand commands[Window::MAX_EVENT_COMMANDS];
+			int commands_count = Window::getEventCommands(events[e].event, commands);
+			std::chrono::steady_clock::time_point due = started + std::chrono::microseconds(events[e].time);
+
+			// Paced latency counts from the recorded time, so time spent waiting for earlier events is included
+			if (is_paced) {
+				std::this_thread::sleep_until(due);
+			} else {
+				due = std::chrono::steady_clock::now();
+			}
+
+			// Like the window, commands after a failed one are skipped
+			try {
+				for (int c = 0; c < commands_count; c++) {
+					Window::applyCommand(scene, commands[c]);
+				}
+			} catch (const std::exception& err) {
+				errors++;
+			}
+
+			latencies.push_back({
+				std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - due).count(),
+				e,
+			});
+		}
+
+		double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+		std::sort(latencies.begin(), latencies.end(), [](const EventLatency& a, const EventLatency& b) {
+			return a.ns < b.ns;
+		});
+
+		printf(
+			"events: %zu in %.1f ms (%s), %lld with errors, recorded over %.1f ms\n",
+			events.size(),
+			total_ms,
+			is_paced ? "paced" : "as fast as possible",
+			errors,
+			events.empty() ? 0.0 : events.back().time / 1e3
+		);
+		printf(
+			"latency us: p50 %.2f, p90 %.2f, p99 %.2f, max %.2f\n",
+			percentile(latencies, 0.5) / 1e3,
+			percentile(latencies, 0.9) / 1e3,
+			percentile(latencies, 0.99) / 1e3,
+			latencies.empty() ? 0.0 : latencies.back().ns / 1e3
+		);
+
+		for (int s = 0; s < slowest && s < (int)latencies.size(); s++) {
+			const EventLatency& latency = latencies[latencies.size() - 1 - s];
+
+			printf("  #%zu at %.3f s: %.2f us, ", latency.index, events[latency.index].time / 1e6, latency.ns / 1e3);
+			printEvent(events[latency.index].event);
+			printf("\n");
+		}
+
+		if (!trace.isFinished()) {
+			printf("scene hash: not recorded, the trace has no end\n");
+			return 0;
+		}
+
+		unsigned long long hash = Window::hashScene(scene);
+
+		if (hash != trace.getSceneHash()) {
+			printf(
+				"scene hash: MISMATCH, recorded %016llx with %d figures, replayed %016llx with %d figures\n",
+				trace.getSceneHash(),
+				trace.getFigureCount(),
+				hash,
+				scene.countElements()
+			);
+			return 1;
+		}
+
+		printf("scene hash: %016llx, %d figures\n", hash, scene.countElements());
+	} catch (const std::exception& err) {
+		fprintf(stderr, "%s\n", err.what());
+		return 2;
+	}
+
+	return 0;
+}
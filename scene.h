@@ -0,0 +1,1134 @@
+#ifndef PAINTING_SCENE_H
+#define PAINTING_SCENE_H
+
+#include <vector>
+#include <thread>
+#include <utility>
+#include <stdexcept>
+
+#include "figure.h"
+#include "arena.h"
+#include "shapes.h"
+#include "overlap.h"
+#include "nearest.h"
+#include "hierarchy.h"
+#include "telemetry.h"
+
+namespace Window {
+	/*!
+		\brief Parameters of a figure for bulk loading, see Scene::newFigures
+		\version 1.0.0
+		\author Crinax
+	*/
+	struct FigureSpec {
+		Window::Point center;
+		int radius;
+		int vertices_number;
+		double angle;
+	};
+
+	// Flags of figures filled by getFigureStates, owned by the renderer and reused between frames
+	typedef Window::TrackedVector<unsigned char, Window::MEMORY_RENDERER> FigureStates;
+
+	/*!
+		\brief Interface for objects following changes of figures of the scene
+		\details Indices are the indices of figures at the moment of the call. After
+			onFigureRemoved figures behind the removed one are shifted down by one.
+		\version 1.1.0
+		\author Crinax
+	*/
+	class SceneListener {
+		public:
+			virtual ~SceneListener() {}
+
+			// Figure was appended to the scene
+			virtual void onFigureAdded(int index) = 0;
+
+			// Figure was removed from the scene
+			virtual void onFigureRemoved(int index) = 0;
+
+			// Pose of the figure was changed
+			virtual void onFigureChanged(int index) = 0;
+
+			// Figure became active, selected or highlighted, or stopped being it
+			virtual void onFigureStateChanged(int index) = 0;
+
+			// All figures were removed
+			virtual void onSceneCleared() = 0;
+	};
+
+	/*!
+		\brief Scene class for defining figures and them management
+		\details The scene is the only owner of active and selected state: one index for
+			each, plus a bitset of figures highlighted by the lock mode. Switching, locking
+			and inserting touch only the figures whose state changes. Figures are stored
+			in an arena and never move, the scene keeps their addresses in index order.
+			Shapes of figures are templates of the library shared with other scenes.
+		\version 1.13.0
+		\author Crinax
+		\date 10.04.2022
+	*/
+	class Scene {
+		public:
+			// Figures appended by one step of newFiguresFrom, also the least built by several threads
+			static const size_t BULK_BATCH = 1 << 16;
+
+			// Flags of getFigureState
+			static const unsigned char FIGURE_ACTIVE = 1;
+			static const unsigned char FIGURE_SELECTED = 2;
+
+			/*!
+				\brief Main constructor for class
+				\param [in] library {Templates of figures, shared with other scenes}
+			*/
+			Scene(Window::TemplateLibrary& library = Window::TemplateLibrary::getShared()) : library(library) {
+				this->element_count = 0;
+				this->active_figure = -1;
+				this->selected_figure = -1;
+				this->is_blocked = false;
+				this->active_figure_before_block = -1;
+				this->selected_figure_before_block = -1;
+				this->has_root_figures = false;
+				this->snap_mode = Window::SNAP_OFF;
+				this->figures = {};
+
+				for (int kind = 0; kind <= Window::Figure::MAX_VERTICES; kind++) {
+					this->largest_figures[kind] = -1;
+					this->is_largest_stale[kind] = false;
+					this->templates[kind] = NULL;
+				}
+			}
+
+			Scene(const Scene&) = delete;
+			Scene& operator=(const Scene&) = delete;
+			
+			~Scene() {
+				this->figures.clear();
+				this->overlaps.clear();
+				this->nearest.clear();
+				this->hierarchy.clear();
+
+				for (int kind = 0; kind <= Window::Figure::MAX_VERTICES; kind++) {
+					if (this->templates[kind] != NULL) {
+						this->library.release(this->templates[kind]);
+					}
+				}
+			}
+
+			/*!
+				\brief Returns the figure by index, if the index > max figures throws error
+				\param [in] index {Index of the figure}
+			*/
+			Figure getFigure(int index) {
+				if (index >= this->element_count) {
+					throw std::out_of_range("[ERR] Window::Scene: index greeter than max possible figures");
+				}
+
+				this->updateWorldTransforms();
+
+				return *this->figures[index];
+			}
+
+			/*!
+				\brief Returns address of the figure, if the index > max figures throws error
+				\details Figures never move in memory, the address stays valid until the figure
+					is deleted. Poses of children are brought up to date only by getFigure
+					and updateWorldTransforms.
+				\param [in] index {Index of the figure}
+			*/
+			const Window::Figure* getFigureAddress(int index) {
+				if (index >= this->element_count) {
+					throw std::out_of_range("[ERR] Window::Scene: index greeter than max possible figures");
+				}
+
+				return this->figures[index];
+			}
+
+			// Returns bytes used by figures, held by the scene and the most ever held
+			Window::ArenaStats getFigureMemory() {
+				return this->arena.getStats();
+			}
+
+			/*!
+				\brief Creates new figure
+				\param [in] center {Coords of center of the figure}
+				\param [in] radius {Radius of circumscribed circle around the figure}
+				\param [in] vertices_number {Number of vertices of the figure (MAX_VERTICES=10)}
+				\param [in] angle {Angle of rotation of the figure}
+				\param [in] is_active {Determines whether the figure becomes active, the first figure always does}
+			*/
+			void newFigure(Point center, int radius, int vertices_number, double angle, bool is_active) {
+				Window::Figure figure = {
+					this->getTemplate(vertices_number),
+					center,
+					radius,
+					angle,
+				};
+
+				this->figures.push_back(this->arena.allocate());
+				*this->figures.back() = figure;
+				this->overlaps.insert(*this->figures.back());
+				this->nearest.insert(*this->figures.back());
+				this->hierarchy.insert(*this->figures.back());
+				this->has_root_figures = false;
+				this->updateLargestFigure(this->element_count);
+
+				for (size_t l = 0; l < this->listeners.size(); l++) {
+					this->listeners[l]->onFigureAdded(this->element_count);
+				}
+
+				this->element_count++;
+
+				this->clearHighlightedFigures();
+
+				if (is_active || this->active_figure == -1) {
+					this->setActiveFigure(this->element_count - 1);
+				}
+			}
+
+			/*!
+				\brief Creates many figures at once, the last one becomes active
+				\details Storage is reserved once, vertices are built in parallel for large batches
+					and the active figure is switched once, so loading n figures is O(n).
+				\param [in] specs {Parameters of the new figures}
+			*/
+			void newFigures(const std::vector<Window::FigureSpec>& specs) {
+				this->reserveFigures(specs.size());
+				this->beginBulkInsert();
+				this->appendFigures(specs);
+				this->endBulkInsert();
+			}
+
+			/*!
+				\brief Creates figures produced by the generator, the last one becomes active
+				\details Generator is called as bool(FigureSpec&) until it returns false.
+					Figures are appended in batches, so the specs are never all in memory.
+				\param [in] generate {Generator of figure parameters}
+				\param [in] count_hint {Expected number of figures, used to reserve storage}
+			*/
+			template <typename Generator>
+			void newFiguresFrom(Generator generate, size_t count_hint = 0) {
+				std::vector<Window::FigureSpec> batch;
+				Window::FigureSpec spec;
+
+				batch.reserve(Window::Scene::BULK_BATCH);
+				this->reserveFigures(count_hint);
+				this->beginBulkInsert();
+
+				while (generate(spec)) {
+					batch.push_back(spec);
+
+					if (batch.size() == Window::Scene::BULK_BATCH) {
+						this->appendFigures(batch);
+						batch.clear();
+					}
+				}
+
+				this->appendFigures(batch);
+				this->endBulkInsert();
+			}
+
+			/*!
+				\brief Returns number of threads building vertices of appended figures
+				\details Every batch of newFiguresFrom is built in parallel, smaller inserts in one thread
+				\param [in] count {Number of appended figures}
+				\param [in] hardware_threads {Threads the hardware runs at once}
+			*/
+			static size_t countBuildThreads(size_t count, size_t hardware_threads) {
+				if (count < Window::Scene::BULK_BATCH || hardware_threads < 2) {
+					return 1;
+				}
+
+				return hardware_threads;
+			}
+
+			/*!
+				\brief Rotate the active figure
+				\param [in] angle {How many radians the figure rotate by}
+			*/
+			void rotateActiveFigure(double angle) {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				this->refreshFigure(this->active_figure);
+				this->figures[this->active_figure]->rotate(angle);
+				this->figureMoved(this->active_figure);
+			}
+
+			/*!
+				\brief Switch active figure to previous
+				\bug Doesn't work correctly
+				\todo Fix the switching
+			*/
+			void setPrevFigureAsActive() {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				int previous = this->active_figure;
+
+				this->decreaseActiveFigureIndex();
+				this->notifyStateChanged(previous);
+				this->notifyStateChanged(this->active_figure);
+			}
+
+			/*!
+				\brief Switch active figure to next
+			*/
+			void setNextFigureAsActive() {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				int previous = this->active_figure;
+
+				this->increaseActiveFigureIndex();
+				this->notifyStateChanged(previous);
+				this->notifyStateChanged(this->active_figure);
+			}
+
+			/*!
+				\brief Move the active figure to point
+				\param [in] point {What point to move the figure to}
+			*/
+			void moveActiveFigureTo(Window::Point point) {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				this->refreshFigure(this->active_figure);
+				this->figures[this->active_figure]->moveTo(point);
+				this->figureMoved(this->active_figure);
+			}
+
+			/*!
+				\brief Move the active figure to selected
+				\param [in] point {What point to move the figure to}
+			*/
+			void moveActiveFigureToSelected() {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				if (this->selected_figure == -1) {
+					throw std::runtime_error("[ERR] Window::Scene: No selected figures");
+				}
+
+				this->updateWorldTransforms();
+				this->figures[this->active_figure]->moveTo(this->figures[this->selected_figure]->getPosition());
+				this->figureMoved(this->active_figure);
+			}
+
+			/*!
+				\brief Move the active figure to the point or to what is nearest to it, see setNextSnapMode
+				\details The figure and its descendants are never the target, they move with it.
+					Without other figures the figure is moved to the point itself.
+				\param [in] point {What point to move the figure to}
+			*/
+			void moveActiveFigureNear(Window::Point point) {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				if (this->snap_mode == Window::SNAP_OFF) {
+					this->moveActiveFigureTo(point);
+					return;
+				}
+
+				this->updateWorldTransforms();
+
+				auto is_target = [this](int index) {
+					return !this->isInActiveSubtree(index);
+				};
+
+				if (this->snap_mode == Window::SNAP_TO_CENTER) {
+					this->nearest.findNearestCenters(point, 1, is_target, this->snap_targets);
+				} else {
+					this->nearest.findNearestVertices(point, 1, this->figures, is_target, this->snap_targets);
+				}
+
+				this->figures[this->active_figure]->moveTo(this->snap_targets.empty() ? point : this->snap_targets[0].point);
+				this->figureMoved(this->active_figure);
+			}
+
+			// Switch to the next snap mode: off, to centers, to vertices
+			void setNextSnapMode() {
+				this->snap_mode = (Window::SnapMode)((this->snap_mode + 1) % Window::SNAP_MODES);
+			}
+
+			Window::SnapMode getSnapMode() {
+				return this->snap_mode;
+			}
+
+			/*!
+				\brief Find figure centers nearest to the point
+				\param [in] point {The point}
+				\param [in] k {Number of centers}
+				\param [out] result {Up to k centers, the closest first}
+			*/
+			void findNearestCenters(Window::Point point, int k, Window::NearestList& result) {
+				this->updateWorldTransforms();
+				this->nearest.findNearestCenters(point, k, [](int) { return true; }, result);
+			}
+
+			/*!
+				\brief Find vertices of figures nearest to the point
+				\param [in] point {The point}
+				\param [in] k {Number of vertices}
+				\param [out] result {Up to k vertices, the closest first}
+			*/
+			void findNearestVertices(Window::Point point, int k, Window::NearestList& result) {
+				this->updateWorldTransforms();
+				this->nearest.findNearestVertices(point, k, this->figures, [](int) { return true; }, result);
+			}
+
+			// Increase the active figure radius by 1
+			void increaseActiveFigureRadius() {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				this->refreshFigure(this->active_figure);
+				this->figures[this->active_figure]->scale(1);
+				this->updateLargestFigure(this->active_figure);
+				this->figureMoved(this->active_figure);
+			}
+
+			// Decrease the active figure radius by 1
+			void decreaseActiveFigureRadius() {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				this->refreshFigure(this->active_figure);
+				this->figures[this->active_figure]->scale(-1);
+				this->shrinkLargestFigure(this->active_figure);
+				this->figureMoved(this->active_figure);
+			}
+
+			// Delete active figure with switching active figure to previous
+			void deleteActiveFigure() {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				this->updateWorldTransforms();
+
+				int removed = this->active_figure;
+
+				this->eraseLargestFigure(removed);
+
+				this->element_count--;
+				this->arena.release(this->figures[removed]);
+				this->figures.erase(this->figures.begin() + removed);
+				this->overlaps.erase(removed);
+				this->nearest.erase(removed);
+				this->hierarchy.erase(removed);
+				this->has_root_figures = false;
+
+				for (size_t l = 0; l < this->listeners.size(); l++) {
+					this->listeners[l]->onFigureRemoved(removed);
+				}
+
+				// Selection follows its figure, which moved down if it was behind the removed one
+				if (this->selected_figure == removed) {
+					this->selected_figure = -1;
+				} else if (this->selected_figure > removed) {
+					this->selected_figure--;
+				}
+
+				if (this->active_figure == this->element_count) {
+					this->active_figure--;
+				}
+				
+				if (this->active_figure == 0) {
+					this->active_figure = this->element_count - 1;
+				}
+
+				if (this->active_figure == this->selected_figure) {
+					this->notifyStateChanged(this->selected_figure);
+					this->selected_figure = -1;
+				}
+
+				if (this->active_figure != -1) {
+					this->notifyStateChanged(this->active_figure);
+				}
+			}
+
+			/*!
+				\brief Rotate all figures
+				\details Only root figures are rotated, children follow their parents
+				\param [in] angle {How many radians the figures rotate by}
+			*/
+			void rotateAllFigures(double angle) {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				this->updateRootFigures();
+
+				for (size_t r = 0; r < this->root_figures.size(); r++) {
+					int i = this->root_figures[r];
+
+					this->figures[i]->rotate(angle);
+					this->hierarchy.markMoved(i, *this->figures[i]);
+					this->notifyChanged(i);
+				}
+			}
+
+			// Select active figure
+			void selectActiveFigure() {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+				
+				int previous = this->selected_figure;
+
+				if (this->selected_figure == this->active_figure) {
+					this->selected_figure = -1;
+				} else {
+					this->selected_figure = this->active_figure;
+				}
+
+				if (previous != -1 && previous != this->active_figure) {
+					this->notifyStateChanged(previous);
+				}
+
+				this->notifyStateChanged(this->active_figure);
+			}
+
+			/*!
+				\brief Rotate figure around selected figure or around self
+				\param [in] angle {How many radians the figures rotate by}
+			*/
+			void rotateActiveFigureAroundSelected(double angle) {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				this->updateWorldTransforms();
+
+				if (this->selected_figure == this->active_figure || this->selected_figure == -1) {
+					this->figures[this->active_figure]->rotate(angle);
+				} else {
+					this->figures[this->active_figure]->rotateAround(
+						this->figures[this->selected_figure]->getPosition(),
+						angle
+					);
+				}
+
+				this->figureMoved(this->active_figure);
+			}
+
+			/*!
+				\brief Rotate figure around point
+				\param [in] point {The point around which to turn}
+				\param [in] angle {How many radians the figures rotate by}
+			*/
+			void rotateActiveFigureAroundPoint(Window::Point point, double angle) {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				this->refreshFigure(this->active_figure);
+				this->figures[this->active_figure]->rotateAround(
+					point,
+					angle
+				);
+				this->figureMoved(this->active_figure);
+			}
+
+			// Deleting all figures from sceen
+			void deleteAllFigures() {
+				this->element_count = 0;
+				this->active_figure = -1;
+				this->selected_figure = -1;
+				this->active_figure_before_block = -1;
+				this->selected_figure_before_block = -1;
+
+				this->figures.clear();
+				this->arena.releaseAll();
+				this->overlaps.clear();
+				this->nearest.clear();
+				this->hierarchy.clear();
+				this->has_root_figures = false;
+				this->highlighted_figures.clear();
+				this->highlight_mask.clear();
+
+				for (int kind = 0; kind <= Window::Figure::MAX_VERTICES; kind++) {
+					this->largest_figures[kind] = -1;
+					this->is_largest_stale[kind] = false;
+				}
+
+				for (size_t l = 0; l < this->listeners.size(); l++) {
+					this->listeners[l]->onSceneCleared();
+				}
+			}
+
+			/*!
+				\brief Make the active figure child of the selected one
+				\details The child keeps its place, later it moves and rotates together with the parent
+			*/
+			void attachActiveFigureToSelected() {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				if (this->selected_figure == -1 || this->selected_figure == this->active_figure) {
+					throw std::runtime_error("[ERR] Window::Scene: No selected figures");
+				}
+
+				this->updateWorldTransforms();
+				this->hierarchy.attach(this->active_figure, this->selected_figure);
+				this->has_root_figures = false;
+			}
+
+			// Make the active figure root again
+			void detachActiveFigure() {
+				this->checkFiguresLength();
+				this->checkIsSceneBlocking();
+
+				this->updateWorldTransforms();
+				this->hierarchy.detach(this->active_figure);
+				this->has_root_figures = false;
+			}
+
+			/*!
+				\brief Returns index of the parent figure or -1 for root figures
+				\param [in] index {Index of the figure}
+			*/
+			int getParentFigure(int index) {
+				if (index >= this->element_count) {
+					throw std::out_of_range("[ERR] Window::Scene: index greeter than max possible figures");
+				}
+
+				return this->hierarchy.getParent(index);
+			}
+
+			/*!
+				\brief Subscribe to changes of figures
+				\details The listener is not owned and must be removed before it is destroyed
+				\param [in] listener {The listener}
+			*/
+			void addListener(Window::SceneListener* listener) {
+				this->listeners.push_back(listener);
+			}
+
+			/*!
+				\brief Unsubscribe from changes of figures
+				\param [in] listener {The listener}
+			*/
+			void removeListener(Window::SceneListener* listener) {
+				for (size_t l = 0; l < this->listeners.size(); l++) {
+					if (this->listeners[l] == listener) {
+						this->listeners.erase(this->listeners.begin() + l);
+						return;
+					}
+				}
+			}
+
+			// Returns index of the active figure or -1
+			int getActiveFigureIndex() {
+				return this->active_figure;
+			}
+
+			// Returns index of the selected figure or -1
+			int getSelectedFigureIndex() {
+				return this->selected_figure;
+			}
+
+			// Returns true if the figure is active or highlighted by the lock mode
+			bool isFigureActive(int index) {
+				return index == this->active_figure || this->isFigureHighlighted(index);
+			}
+
+			// Returns true if the figure is selected
+			bool isFigureSelected(int index) {
+				return index == this->selected_figure;
+			}
+
+			// Returns FIGURE_ACTIVE and FIGURE_SELECTED flags of the figure
+			unsigned char getFigureState(int index) {
+				return (this->isFigureActive(index) ? Window::Scene::FIGURE_ACTIVE : 0)
+					| (this->isFigureSelected(index) ? Window::Scene::FIGURE_SELECTED : 0);
+			}
+
+			/*!
+				\brief Returns flags of figures [first, first + count) at once
+				\details Costs O(count) plus the number of highlighted figures
+				\param [in] first {Index of the first figure}
+				\param [in] count {Number of figures}
+				\param [out] states {Flags of the figures, resized to count}
+			*/
+			void getFigureStates(int first, int count, Window::FigureStates& states) {
+				states.assign(count, 0);
+
+				for (size_t h = 0; h < this->highlighted_figures.size(); h++) {
+					int index = this->highlighted_figures[h] - first;
+
+					if (index >= 0 && index < count) {
+						states[index] |= Window::Scene::FIGURE_ACTIVE;
+					}
+				}
+
+				if (this->active_figure >= first && this->active_figure < first + count) {
+					states[this->active_figure - first] |= Window::Scene::FIGURE_ACTIVE;
+				}
+
+				if (this->selected_figure >= first && this->selected_figure < first + count) {
+					states[this->selected_figure - first] |= Window::Scene::FIGURE_SELECTED;
+				}
+			}
+
+			/*!
+				\brief Returns bitset of figures highlighted by the lock mode, bit i is figure i
+				\details Words past the last highlighted figure are not stored, the bitset is
+					empty when nothing is highlighted
+			*/
+			const Window::TrackedVector<unsigned long long, Window::MEMORY_SCENE>& getHighlightMask() {
+				return this->highlight_mask;
+			}
+
+			/*!
+				\brief Recompute poses of figures whose ancestors were changed
+				\details Called lazily before figures are read, every changed subtree is visited once
+			*/
+			void updateWorldTransforms() {
+				if (!this->hierarchy.isDirty()) {
+					return;
+				}
+
+				this->hierarchy.update(this->figures, this->changed_figures);
+
+				for (size_t i = 0; i < this->changed_figures.size(); i++) {
+					this->overlaps.update(this->changed_figures[i], *this->figures[this->changed_figures[i]]);
+					this->nearest.update(this->changed_figures[i], *this->figures[this->changed_figures[i]]);
+					this->notifyChanged(this->changed_figures[i]);
+				}
+			}
+
+			/*!
+				\brief Returns all pairs of overlapping figures
+				\details Pairs are (lower index, higher index), each pair is reported once
+			*/
+			std::vector<std::pair<int, int>> getOverlappingPairs() {
+				std::vector<std::pair<int, int>> pairs;
+
+				this->updateWorldTransforms();
+				this->overlaps.findOverlappingPairs(this->figures, pairs);
+
+				return pairs;
+			}
+
+			/*!
+				\brief Returns indices of figures overlapping the figure
+				\param [in] index {Index of the figure}
+			*/
+			std::vector<int> getOverlapsOf(int index) {
+				if (index >= this->element_count) {
+					throw std::out_of_range("[ERR] Window::Scene: index greeter than max possible figures");
+				}
+
+				std::vector<int> result;
+
+				this->updateWorldTransforms();
+				this->overlaps.findOverlapsOf(index, this->figures, result);
+
+				return result;
+			}
+
+			void lockScene() {
+				this->checkFiguresLength();
+
+				this->active_figure_before_block = this->active_figure;
+				this->selected_figure_before_block = this->selected_figure;
+				this->active_figure = -1;
+				this->selected_figure = -1;
+				this->is_blocked = true;
+
+				this->notifyStateChanged(this->active_figure_before_block);
+
+				if (this->selected_figure_before_block != -1 && this->selected_figure_before_block != this->active_figure_before_block) {
+					this->notifyStateChanged(this->selected_figure_before_block);
+				}
+			}
+
+			void unlockScene() {
+				this->checkFiguresLength();
+
+				this->active_figure = this->active_figure_before_block;
+				this->selected_figure = this->selected_figure_before_block;
+				this->active_figure_before_block = -1;
+				this->selected_figure_before_block = -1;
+				this->is_blocked = false;
+
+				this->notifyStateChanged(this->active_figure);
+
+				if (this->selected_figure != -1 && this->selected_figure != this->active_figure) {
+					this->notifyStateChanged(this->selected_figure);
+				}
+			}
+
+			// Remove highlighting left by the lock mode
+			void restoreAfterBlocking() {
+				this->clearHighlightedFigures();
+			}
+
+			void setLargestFigureAsActiveByVerticesCount(int vertices_count) {
+				this->checkFiguresLength();
+
+				int figure_index = this->getLargeFigureByVerticesCount(vertices_count);
+
+				if (figure_index != -1) {
+					this->highlightFigure(figure_index);
+				}
+			}
+
+			void setAllLargestFigureAsActive() {
+				this->checkFiguresLength();
+
+				for (int i = 3; i <= Window::Figure::MAX_VERTICES; i++) {
+					this->setLargestFigureAsActiveByVerticesCount(i);
+				}
+			}
+
+			bool isBlocked() {
+				return this->is_blocked;
+			}
+
+			int countElements() {
+				return this->element_count;
+			}
+
+		protected:
+			int element_count;
+			int active_figure;
+			int selected_figure;
+			bool is_blocked;
+			int active_figure_before_block;
+			int selected_figure_before_block;
+			Window::TemplateLibrary& library;
+			// Templates taken from the library, kept until the scene is destroyed
+			const Window::FigureTemplate* templates[Window::Figure::MAX_VERTICES + 1];
+			Window::FigureArena arena;
+			Window::FigureList figures;
+			Window::OverlapIndex overlaps;
+			Window::NearestIndex nearest;
+			Window::SnapMode snap_mode;
+			// Result of the last snapping query, kept so dragging doesn't allocate
+			Window::NearestList snap_targets;
+			Window::Hierarchy hierarchy;
+			Window::TrackedVector<int, Window::MEMORY_SCENE> changed_figures;
+			std::vector<Window::SceneListener*> listeners;
+			Window::TrackedVector<int, Window::MEMORY_SCENE> root_figures;
+			bool has_root_figures;
+			Window::TrackedVector<int, Window::MEMORY_SCENE> highlighted_figures;
+			Window::TrackedVector<unsigned long long, Window::MEMORY_SCENE> highlight_mask;
+			int largest_figures[Window::Figure::MAX_VERTICES + 1];
+			bool is_largest_stale[Window::Figure::MAX_VERTICES + 1];
+
+			// Collect indices of initialized root figures, kept until figures are added, removed or attached
+			void updateRootFigures() {
+				if (this->has_root_figures) {
+					return;
+				}
+
+				this->root_figures.clear();
+
+				for (int i = 0; i < this->element_count; i++) {
+					if (this->figures[i]->is_initialized && this->hierarchy.getParent(i) == -1) {
+						this->root_figures.push_back(i);
+					}
+				}
+
+				this->has_root_figures = true;
+			}
+
+			/*!
+				\brief Returns template for figures with vertices_number vertices, taken from the library once
+				\details Throws if the number is out of [0, MAX_VERTICES]
+			*/
+			const Window::FigureTemplate* getTemplate(int vertices_number) {
+				if (vertices_number >= 0 && vertices_number <= Window::Figure::MAX_VERTICES && this->templates[vertices_number] != NULL) {
+					return this->templates[vertices_number];
+				}
+
+				// Library throws for wrong numbers of vertices
+				const Window::FigureTemplate* shape = this->library.acquire(vertices_number);
+
+				this->templates[vertices_number] = shape;
+
+				return shape;
+			}
+
+			// Reserve index storage for more figures, figures themselves live in the arena
+			void reserveFigures(size_t count) {
+				this->figures.reserve(this->figures.size() + count);
+				this->overlaps.reserve(this->figures.size() + count);
+				this->nearest.reserve(this->figures.size() + count);
+				this->hierarchy.reserve(this->figures.size() + count);
+			}
+
+			// Remove highlighting once before bulk insert
+			void beginBulkInsert() {
+				this->clearHighlightedFigures();
+			}
+
+			// Make the last figure active after bulk insert
+			void endBulkInsert() {
+				if (this->element_count == 0) {
+					return;
+				}
+
+				this->setActiveFigure(this->element_count - 1);
+			}
+
+			// Append inactive figures, vertices are built by several threads for large batches
+			void appendFigures(const std::vector<Window::FigureSpec>& specs) {
+				// Templates are taken before building, which may run in several threads
+				for (size_t i = 0; i < specs.size(); i++) {
+					this->getTemplate(specs[i].vertices_number);
+				}
+
+				size_t first = this->figures.size();
+				size_t count = specs.size();
+				size_t threads_count = Window::Scene::countBuildThreads(count, std::thread::hardware_concurrency());
+
+				this->figures.resize(first + count);
+
+				for (size_t i = first; i < first + count; i++) {
+					this->figures[i] = this->arena.allocate();
+				}
+
+				if (threads_count < 2) {
+					this->buildFigures(specs, first, 0, count);
+				} else {
+					std::vector<std::thread> threads;
+					size_t part = (count + threads_count - 1) / threads_count;
+
+					for (size_t t = 1; t < threads_count && t * part < count; t++) {
+						threads.push_back(std::thread(
+							&Window::Scene::buildFigures,
+							this,
+							std::cref(specs),
+							first,
+							t * part,
+							std::min(count, (t + 1) * part)
+						));
+					}
+
+					this->buildFigures(specs, first, 0, std::min(count, part));
+
+					for (size_t t = 0; t < threads.size(); t++) {
+						threads[t].join();
+					}
+				}
+
+				for (size_t i = first; i < first + count; i++) {
+					this->overlaps.insert(*this->figures[i]);
+					this->nearest.insert(*this->figures[i]);
+					this->hierarchy.insert(*this->figures[i]);
+					this->updateLargestFigure((int)i);
+				}
+
+				this->has_root_figures = false;
+
+				for (size_t i = first; i < first + count; i++) {
+					for (size_t l = 0; l < this->listeners.size(); l++) {
+						this->listeners[l]->onFigureAdded((int)i);
+					}
+				}
+
+				this->element_count += (int)count;
+			}
+
+			// Construct figures specs[from, to) into figures starting at first
+			void buildFigures(const std::vector<Window::FigureSpec>& specs, size_t first, size_t from, size_t to) {
+				for (size_t i = from; i < to; i++) {
+					*this->figures[first + i] = Window::Figure(
+						this->templates[specs[i].vertices_number],
+						specs[i].center,
+						specs[i].radius,
+						specs[i].angle
+					);
+				}
+			}
+
+			// Tell listeners that the figure was changed in place
+			void notifyChanged(int index) {
+				for (size_t l = 0; l < this->listeners.size(); l++) {
+					this->listeners[l]->onFigureChanged(index);
+				}
+			}
+
+			// Tell listeners that the figure became or stopped being active or selected
+			void notifyStateChanged(int index) {
+				for (size_t l = 0; l < this->listeners.size(); l++) {
+					this->listeners[l]->onFigureStateChanged(index);
+				}
+			}
+
+			// Make the figure active instead of the current one
+			void setActiveFigure(int index) {
+				int previous = this->active_figure;
+
+				if (previous == index) {
+					return;
+				}
+
+				this->active_figure = index;
+
+				if (previous != -1) {
+					this->notifyStateChanged(previous);
+				}
+
+				this->notifyStateChanged(index);
+			}
+
+			bool isFigureHighlighted(int index) {
+				size_t word = (size_t)index / 64;
+
+				return index >= 0
+					&& word < this->highlight_mask.size()
+					&& (this->highlight_mask[word] >> (index % 64) & 1);
+			}
+
+			// Add the figure to the highlighted set of the lock mode
+			void highlightFigure(int index) {
+				if (this->isFigureHighlighted(index)) {
+					return;
+				}
+
+				size_t word = (size_t)index / 64;
+
+				if (word >= this->highlight_mask.size()) {
+					this->highlight_mask.resize(word + 1, 0);
+				}
+
+				this->highlight_mask[word] |= 1ULL << (index % 64);
+				this->highlighted_figures.push_back(index);
+				this->notifyStateChanged(index);
+			}
+
+			// Empty the highlighted set, only highlighted figures are visited
+			void clearHighlightedFigures() {
+				for (size_t h = 0; h < this->highlighted_figures.size(); h++) {
+					this->notifyStateChanged(this->highlighted_figures[h]);
+				}
+
+				this->highlighted_figures.clear();
+				this->highlight_mask.clear();
+			}
+
+			// Take the added or grown figure into account as the largest of its kind
+			void updateLargestFigure(int index) {
+				int kind = this->figures[index]->countVertices();
+
+				if (kind < 0 || kind > Window::Figure::MAX_VERTICES || this->is_largest_stale[kind]) {
+					return;
+				}
+
+				int largest = this->largest_figures[kind];
+
+				// Later figure wins a tie
+				if (
+					largest == -1
+					|| this->figures[largest]->getRadius() < this->figures[index]->getRadius()
+					|| (this->figures[largest]->getRadius() == this->figures[index]->getRadius() && largest < index)
+				) {
+					this->largest_figures[kind] = index;
+				}
+			}
+
+			// Forget the largest figure of the kind if it was shrunk, found again on demand
+			void shrinkLargestFigure(int index) {
+				int kind = this->figures[index]->countVertices();
+
+				if (kind >= 0 && kind <= Window::Figure::MAX_VERTICES && this->largest_figures[kind] == index) {
+					this->is_largest_stale[kind] = true;
+				}
+			}
+
+			// Shift indices of the largest figures before the figure is erased
+			void eraseLargestFigure(int index) {
+				for (int kind = 0; kind <= Window::Figure::MAX_VERTICES; kind++) {
+					if (this->largest_figures[kind] == index) {
+						this->largest_figures[kind] = -1;
+						this->is_largest_stale[kind] = true;
+					} else if (this->largest_figures[kind] > index) {
+						this->largest_figures[kind]--;
+					}
+				}
+			}
+
+			// Returns true for the active figure and its descendants
+			bool isInActiveSubtree(int index) {
+				while (index != -1 && index != this->active_figure) {
+					index = this->hierarchy.getParent(index);
+				}
+
+				return index != -1;
+			}
+
+			// Bring the figure pose up to date before changing it
+			void refreshFigure(int index) {
+				if (this->hierarchy.hasDirtyAncestor(index)) {
+					this->updateWorldTransforms();
+				}
+			}
+
+			// Pass changed pose of the figure to the hierarchy and the spatial indices
+			void figureMoved(int index) {
+				this->hierarchy.markMoved(index, *this->figures[index]);
+				this->overlaps.update(index, *this->figures[index]);
+				this->nearest.update(index, *this->figures[index]);
+				this->notifyChanged(index);
+			}
+
+			// Throws error if the figures length == 0
+			void checkFiguresLength() {
+				if (this->element_count < 1) {
+					throw std::runtime_error("[ERR] Window::Scene: No figures to do this action");
+				}
+			}
+
+			void checkIsSceneBlocking() {
+				if (this->is_blocked) {
+					throw std::runtime_error("[ERR] Window::Scene: Scene was blocked");
+				}
+			}
+
+			/*!
+				\brief Returns the largest figure with vertices_count vertices or -1
+				\details Kept up to date on insert and growth, figures of the kind are scanned
+					only after its largest figure shrank or was removed
+			*/
+			int getLargeFigureByVerticesCount(int vertices_count) {
+				this->checkFiguresLength();
+
+				if (vertices_count < 0 || vertices_count > Window::Figure::MAX_VERTICES) {
+					return -1;
+				}
+
+				if (this->is_largest_stale[vertices_count]) {
+					this->largest_figures[vertices_count] = -1;
+					this->is_largest_stale[vertices_count] = false;
+
+					for (int i = 0; i < this->element_count; i++) {
+						if (this->figures[i]->countVertices() == vertices_count) {
+							this->updateLargestFigure(i);
+						}
+					}
+				}
+
+				return this->largest_figures[vertices_count];
+			}
+
+			// Increase active figure index
+			void increaseActiveFigureIndex() {
+				if (this->active_figure == this->element_count - 1) {
+					this->active_figure = 0;
+				} else {
+					this->active_figure++;
+				}
+			}
+
+			// Decrease active figure index
+			void decreaseActiveFigureIndex() {
+				if (this->active_figure == 0) {
+					this->active_figure = this->element_count - 1;
+				} else {
+					this->active_figure--;
+				}
+			}
+	};
+};
+
+#endif
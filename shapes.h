@@ -0,0 +1,112 @@
+#ifndef PAINTING_SHAPES_H
+#define PAINTING_SHAPES_H
+
+#include <stdio.h>
+#include <assert.h>
+#include <mutex>
+#include <stdexcept>
+
+#include "figure.h"
+
+namespace Window {
+	/*!
+		\brief Reference counted figure templates shared between scenes
+		\details One template per number of vertices. Every scene acquires a template once,
+			the first time it needs the kind, and releases it when it is destroyed, so
+			figures keep plain pointers. A template is freed with its last reference.
+			Acquiring and releasing may be done from several threads.
+		\version 1.0.1
+		\author Crinax
+	*/
+	class TemplateLibrary {
+		public:
+			TemplateLibrary() {
+				for (int kind = 0; kind <= Window::FigureTemplate::MAX_VERTICES; kind++) {
+					this->templates[kind] = NULL;
+					this->references[kind] = 0;
+				}
+			}
+
+			~TemplateLibrary() {
+				for (int kind = 0; kind <= Window::FigureTemplate::MAX_VERTICES; kind++) {
+					delete this->templates[kind];
+				}
+			}
+
+			TemplateLibrary(const TemplateLibrary&) = delete;
+			TemplateLibrary& operator=(const TemplateLibrary&) = delete;
+
+			// Library of scenes which were not given their own
+			static TemplateLibrary& getShared() {
+				static TemplateLibrary library;
+
+				return library;
+			}
+
+			/*!
+				\brief Returns the template for figures with vertices_number vertices, made on first use
+				\details Throws if the number is out of [0, MAX_VERTICES]
+				\param [in] vertices_number {Number of vertices}
+			*/
+			const Window::FigureTemplate* acquire(int vertices_number) {
+				std::lock_guard<std::mutex> lock(this->mutex);
+
+				if (vertices_number > Window::FigureTemplate::MAX_VERTICES) {
+					throw std::out_of_range("Window::Figure: Too many vertices");
+				}
+
+				if (vertices_number < 0) {
+					throw std::out_of_range("Window::Figure: Negative number of vertices");
+				}
+
+				if (this->templates[vertices_number] == NULL) {
+					this->templates[vertices_number] = new Window::FigureTemplate(vertices_number);
+				}
+
+				this->references[vertices_number]++;
+
+				return this->templates[vertices_number];
+			}
+
+			/*!
+				\brief Drop the reference taken by acquire
+				\details Scenes release templates in their destructors, so this never throws.
+					A template which isn't acquired from the library is reported and ignored,
+					debug builds stop on the assert.
+				\param [in] shape {The template}
+			*/
+			void release(const Window::FigureTemplate* shape) noexcept {
+				std::lock_guard<std::mutex> lock(this->mutex);
+				int kind = shape->vertices_number;
+				bool is_acquired = kind >= 0
+					&& kind <= Window::FigureTemplate::MAX_VERTICES
+					&& this->templates[kind] == shape
+					&& this->references[kind] > 0;
+
+				if (!is_acquired) {
+					fprintf(stderr, "[ERR] Window::TemplateLibrary: template isn't acquired from this library\n");
+					assert(is_acquired);
+					return;
+				}
+
+				if (--this->references[kind] == 0) {
+					delete this->templates[kind];
+					this->templates[kind] = NULL;
+				}
+			}
+
+			// Returns number of references to the template of the kind
+			int countReferences(int vertices_number) {
+				std::lock_guard<std::mutex> lock(this->mutex);
+
+				return this->references[vertices_number];
+			}
+
+		protected:
+			std::mutex mutex;
+			Window::FigureTemplate* templates[Window::FigureTemplate::MAX_VERTICES + 1];
+			int references[Window::FigureTemplate::MAX_VERTICES + 1];
+	};
+};
+
+#endif
@@ -0,0 +1,441 @@
+#ifndef PAINTING_SNAPSHOT_H
+#define PAINTING_SNAPSHOT_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+
+#include "scene.h"
+
+namespace Window {
+	/*!
+		\brief Immutable block of figures shared between snapshots
+		\version 1.0.0
+		\author Crinax
+	*/
+	struct FigureChunk {
+		static constexpr int SIZE = 1024;
+
+		int count;
+		Window::Figure figures[Window::FigureChunk::SIZE];
+	};
+
+	// Highlight bitset of a snapshot, see Scene::getHighlightMask
+	typedef Window::TrackedVector<unsigned long long, Window::MEMORY_SNAPSHOTS> SnapshotMask;
+
+	/*!
+		\brief Immutable copy of the scene published for renderers
+		\details Chunks which were not changed since the previous snapshot are shared with it,
+			so is the highlight bitset while no figure changes its state.
+		\version 1.2.0
+		\author Crinax
+	*/
+	class SceneSnapshot {
+		public:
+			SceneSnapshot() {
+				this->element_count = 0;
+				this->active_figure = -1;
+				this->selected_figure = -1;
+				this->is_blocked = false;
+				this->version = 0;
+			}
+
+			static void* operator new(size_t bytes) {
+				return Window::MemoryTelemetry::getShared().allocate(bytes, Window::MEMORY_SNAPSHOTS);
+			}
+
+			static void operator delete(void* memory, size_t bytes) {
+				Window::MemoryTelemetry::getShared().deallocate(memory, bytes, Window::MEMORY_SNAPSHOTS);
+			}
+
+			// Returns the figure by index
+			Window::Figure getFigure(int index) const {
+				if (index >= this->element_count) {
+					throw std::out_of_range("[ERR] Window::SceneSnapshot: index greeter than max possible figures");
+				}
+
+				return this->chunks[index / Window::FigureChunk::SIZE]->figures[index % Window::FigureChunk::SIZE];
+			}
+
+			int countElements() const {
+				return this->element_count;
+			}
+
+			int getActiveFigureIndex() const {
+				return this->active_figure;
+			}
+
+			int getSelectedFigureIndex() const {
+				return this->selected_figure;
+			}
+
+			bool isBlocked() const {
+				return this->is_blocked;
+			}
+
+			// Returns true if the figure is active or highlighted by the lock mode
+			bool isFigureActive(int index) const {
+				if (index == this->active_figure) {
+					return true;
+				}
+
+				size_t word = (size_t)index / 64;
+
+				return index >= 0
+					&& this->highlight_mask
+					&& word < this->highlight_mask->size()
+					&& ((*this->highlight_mask)[word] >> (index % 64) & 1);
+			}
+
+			bool isFigureSelected(int index) const {
+				return index == this->selected_figure;
+			}
+
+			// Returns FIGURE_ACTIVE and FIGURE_SELECTED flags of the figure, see Scene::getFigureState
+			unsigned char getFigureState(int index) const {
+				return (this->isFigureActive(index) ? Window::Scene::FIGURE_ACTIVE : 0)
+					| (this->isFigureSelected(index) ? Window::Scene::FIGURE_SELECTED : 0);
+			}
+
+			/*!
+				\brief Returns flags of figures [first, first + count) at once
+				\param [in] first {Index of the first figure}
+				\param [in] count {Number of figures}
+				\param [out] states {Flags of the figures, resized to count}
+			*/
+			void getFigureStates(int first, int count, Window::FigureStates& states) const {
+				states.assign(count, 0);
+
+				if (this->highlight_mask) {
+					const Window::SnapshotMask& mask = *this->highlight_mask;
+
+					for (size_t word = first / 64; word < mask.size() && (int)(word * 64) < first + count; word++) {
+						if (mask[word] == 0) {
+							continue;
+						}
+
+						for (int bit = 0; bit < 64; bit++) {
+							int index = (int)(word * 64) + bit - first;
+
+							if ((mask[word] >> bit & 1) && index >= 0 && index < count) {
+								states[index] |= Window::Scene::FIGURE_ACTIVE;
+							}
+						}
+					}
+				}
+
+				if (this->active_figure >= first && this->active_figure < first + count) {
+					states[this->active_figure - first] |= Window::Scene::FIGURE_ACTIVE;
+				}
+
+				if (this->selected_figure >= first && this->selected_figure < first + count) {
+					states[this->selected_figure - first] |= Window::Scene::FIGURE_SELECTED;
+				}
+			}
+
+			// Returns number of the publication, starting from 1
+			unsigned long long getVersion() const {
+				return this->version;
+			}
+
+			int countChunks() const {
+				return (int)this->chunks.size();
+			}
+
+			/*!
+				\brief Returns the chunk of figures [chunk * FigureChunk::SIZE, ...)
+				\details Unchanged chunks are the same object in consecutive snapshots
+			*/
+			std::shared_ptr<const Window::FigureChunk> getChunk(int chunk) const {
+				return this->chunks[chunk];
+			}
+
+			// Returns highlight bitset or NULL, it is the same object while no figure changes its state
+			const Window::SnapshotMask* getHighlightMask() const {
+				return this->highlight_mask.get();
+			}
+
+		protected:
+			friend class SnapshotPublisher;
+
+			Window::TrackedVector<std::shared_ptr<const Window::FigureChunk>, Window::MEMORY_SNAPSHOTS> chunks;
+			std::shared_ptr<const Window::SnapshotMask> highlight_mask;
+			int element_count;
+			int active_figure;
+			int selected_figure;
+			bool is_blocked;
+			unsigned long long version;
+	};
+
+	/*!
+		\brief Read-copy-update publication of scene snapshots
+		\details One mutator thread edits the scene and calls publish(), which copies only
+			changed chunks and swaps the current snapshot pointer. Render threads enter a
+			reader slot, read the current snapshot without locks and leave the slot.
+			Replaced snapshots are freed by the mutator once every reader that could see
+			them has left (epoch based reclamation). Slots are fixed, MAX_READERS at most.
+		\version 1.0.0
+		\author Crinax
+	*/
+	class SnapshotPublisher : public Window::SceneListener {
+		public:
+			static const int MAX_READERS = 64;
+
+			/*!
+				\brief Main constructor for class, follows changes of the scene
+				\param [in] scene {The working copy edited by the mutator thread}
+			*/
+			SnapshotPublisher(Window::Scene& scene) : scene(scene) {
+				this->epoch.store(1);
+				this->version = 0;
+				this->is_state_dirty = true;
+				this->current.store(new SceneSnapshot());
+
+				for (int i = 0; i < Window::SnapshotPublisher::MAX_READERS; i++) {
+					this->slots[i].is_used.store(false);
+					this->slots[i].epoch.store(0);
+				}
+
+				this->scene.addListener(this);
+				this->markAll();
+			}
+
+			~SnapshotPublisher() {
+				this->scene.removeListener(this);
+
+				for (size_t i = 0; i < this->retired.size(); i++) {
+					delete this->retired[i].snapshot;
+				}
+
+				delete this->current.load();
+			}
+
+			/*!
+				\brief Publish the scene as the new snapshot, mutator thread only
+				\details Reclaims snapshots which no reader can see anymore.
+			*/
+			void publish() {
+				SceneSnapshot* previous = this->current.load();
+				SceneSnapshot* next = new SceneSnapshot();
+				int element_count = this->scene.countElements();
+				int chunk_count = (element_count + Window::FigureChunk::SIZE - 1) / Window::FigureChunk::SIZE;
+
+				next->chunks.resize(chunk_count);
+
+				for (int c = 0; c < chunk_count; c++) {
+					bool is_dirty = c >= (int)this->is_chunk_dirty.size() || this->is_chunk_dirty[c];
+
+					if (!is_dirty && c < (int)previous->chunks.size()) {
+						next->chunks[c] = previous->chunks[c];
+						continue;
+					}
+
+					std::shared_ptr<Window::FigureChunk> chunk = std::allocate_shared<Window::FigureChunk>(
+						Window::TrackedAllocator<Window::FigureChunk, Window::MEMORY_SNAPSHOTS>()
+					);
+					int first = c * Window::FigureChunk::SIZE;
+
+					chunk->count = std::min(Window::FigureChunk::SIZE, element_count - first);
+
+					for (int i = 0; i < chunk->count; i++) {
+						chunk->figures[i] = this->scene.getFigure(first + i);
+					}
+
+					next->chunks[c] = chunk;
+				}
+
+				if (this->is_state_dirty) {
+					const Window::TrackedVector<unsigned long long, Window::MEMORY_SCENE>& mask = this->scene.getHighlightMask();
+
+					if (!mask.empty()) {
+						next->highlight_mask = std::allocate_shared<const Window::SnapshotMask>(
+							Window::TrackedAllocator<Window::SnapshotMask, Window::MEMORY_SNAPSHOTS>(),
+							mask.begin(),
+							mask.end()
+						);
+					}
+
+					this->is_state_dirty = false;
+				} else {
+					next->highlight_mask = previous->highlight_mask;
+				}
+
+				next->element_count = element_count;
+				next->active_figure = this->scene.getActiveFigureIndex();
+				next->selected_figure = this->scene.getSelectedFigureIndex();
+				next->is_blocked = this->scene.isBlocked();
+				next->version = ++this->version;
+
+				this->is_chunk_dirty.assign(chunk_count, false);
+
+				SceneSnapshot* old = this->current.exchange(next);
+
+				this->retired.push_back({ old, this->epoch.fetch_add(1) });
+				this->reclaim();
+			}
+
+			/*!
+				\brief Take a reader slot, every render thread needs its own
+				\details Throws if all MAX_READERS slots are taken
+			*/
+			int registerReader() {
+				for (int i = 0; i < Window::SnapshotPublisher::MAX_READERS; i++) {
+					bool expected = false;
+
+					if (this->slots[i].is_used.compare_exchange_strong(expected, true)) {
+						return i;
+					}
+				}
+
+				throw std::runtime_error("[ERR] Window::SnapshotPublisher: too many readers");
+			}
+
+			// Free the reader slot
+			void unregisterReader(int slot) {
+				this->slots[slot].epoch.store(0);
+				this->slots[slot].is_used.store(false);
+			}
+
+			/*!
+				\brief Start reading, the returned snapshot is valid until leave()
+				\param [in] slot {Slot of the reader thread}
+			*/
+			const SceneSnapshot* enter(int slot) {
+				this->slots[slot].epoch.store(this->epoch.load());
+
+				return this->current.load();
+			}
+
+			/*!
+				\brief Stop reading the snapshot returned by enter()
+				\param [in] slot {Slot of the reader thread}
+			*/
+			void leave(int slot) {
+				this->slots[slot].epoch.store(0);
+			}
+
+			// Returns number of replaced snapshots that are still waiting for readers
+			int countRetired() {
+				return (int)this->retired.size();
+			}
+
+			void onFigureAdded(int index) {
+				this->markChunk(index / Window::FigureChunk::SIZE);
+			}
+
+			void onFigureRemoved(int index) {
+				// Figures behind the removed one are shifted, so all their chunks change
+				for (size_t c = index / Window::FigureChunk::SIZE; c < this->is_chunk_dirty.size(); c++) {
+					this->is_chunk_dirty[c] = true;
+				}
+			}
+
+			void onFigureChanged(int index) {
+				this->markChunk(index / Window::FigureChunk::SIZE);
+			}
+
+			void onFigureStateChanged(int /* index */) {
+				this->is_state_dirty = true;
+			}
+
+			void onSceneCleared() {
+				this->is_chunk_dirty.clear();
+				this->is_state_dirty = true;
+			}
+
+		protected:
+			// Epoch of an active reader or 0, on its own cache line
+			struct alignas(64) ReaderSlot {
+				std::atomic<bool> is_used;
+				std::atomic<unsigned long long> epoch;
+			};
+
+			// Replaced snapshot and the epoch it was replaced in
+			struct RetiredSnapshot {
+				SceneSnapshot* snapshot;
+				unsigned long long epoch;
+			};
+
+			Window::Scene& scene;
+			std::atomic<SceneSnapshot*> current;
+			std::atomic<unsigned long long> epoch;
+			ReaderSlot slots[Window::SnapshotPublisher::MAX_READERS];
+			Window::TrackedVector<RetiredSnapshot, Window::MEMORY_SNAPSHOTS> retired;
+			Window::TrackedVector<bool, Window::MEMORY_SNAPSHOTS> is_chunk_dirty;
+			bool is_state_dirty;
+			unsigned long long version;
+
+			void markChunk(int chunk) {
+				if (chunk >= (int)this->is_chunk_dirty.size()) {
+					this->is_chunk_dirty.resize(chunk + 1, true);
+				}
+
+				this->is_chunk_dirty[chunk] = true;
+			}
+
+			void markAll() {
+				int element_count = this->scene.countElements();
+
+				this->is_chunk_dirty.assign((element_count + Window::FigureChunk::SIZE - 1) / Window::FigureChunk::SIZE, true);
+			}
+
+			// Free retired snapshots older than every active reader
+			void reclaim() {
+				unsigned long long oldest = this->epoch.load();
+
+				for (int i = 0; i < Window::SnapshotPublisher::MAX_READERS; i++) {
+					unsigned long long reader = this->slots[i].epoch.load();
+
+					if (reader != 0 && reader < oldest) {
+						oldest = reader;
+					}
+				}
+
+				size_t kept = 0;
+
+				for (size_t i = 0; i < this->retired.size(); i++) {
+					// Reader that entered in epoch e could load only snapshots retired in e or later
+					if (this->retired[i].epoch < oldest) {
+						delete this->retired[i].snapshot;
+					} else {
+						this->retired[kept++] = this->retired[i];
+					}
+				}
+
+				this->retired.resize(kept);
+			}
+	};
+
+	/*!
+		\brief Reader slot entered for the lifetime of the guard
+		\version 1.0.0
+		\author Crinax
+	*/
+	class SnapshotGuard {
+		public:
+			SnapshotGuard(Window::SnapshotPublisher& publisher, int slot) : publisher(publisher) {
+				this->slot = slot;
+				this->snapshot = publisher.enter(slot);
+			}
+
+			~SnapshotGuard() {
+				this->publisher.leave(this->slot);
+			}
+
+			const Window::SceneSnapshot* operator->() const {
+				return this->snapshot;
+			}
+
+			const Window::SceneSnapshot& operator*() const {
+				return *this->snapshot;
+			}
+
+		protected:
+			Window::SnapshotPublisher& publisher;
+			const Window::SceneSnapshot* snapshot;
+			int slot;
+	};
+};
+
+#endif
@@ -0,0 +1,1058 @@
+#ifndef PAINTING_STREAM_H
+#define PAINTING_STREAM_H
+
+#include <string.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#include "scene.h"
+#include "telemetry.h"
+
+namespace Window {
+#ifdef _WIN32
+	typedef SOCKET StreamSocket;
+	const StreamSocket NO_STREAM_SOCKET = INVALID_SOCKET;
+#else
+	typedef int StreamSocket;
+	const StreamSocket NO_STREAM_SOCKET = -1;
+#endif
+
+	// First bytes sent to every viewer, the last one is the protocol version
+	const unsigned char stream_magic[5] = { 'P', 'S', 'T', 'R', 1 };
+
+	/*!
+		\brief Records of stream messages
+		\details A message is its payload size as 4 little-endian bytes, then the version
+			of the scene it brings the viewer to and records up to the end. Numbers are
+			LEB128 varints, coords are zigzag encoded, angles are 8 raw bytes.
+
+			STREAM_KEYFRAME count, count * figure   whole scene, followed by STREAM_STATE
+			STREAM_ADDED figure                     figure appended to the scene
+			STREAM_REMOVED index                    figures behind it are shifted down
+			STREAM_POSE index x y radius angle      new pose of the figure
+			STREAM_STATE active selected blocked words, words * (skip, bits)
+			STREAM_CLEARED                          all figures were removed
+
+			A figure is vertices x y radius angle. Active and selected are stored plus one,
+			so -1 becomes 0. Words are the nonzero words of the highlight bitset, skip is
+			the number of zero words before the word.
+		\author Crinax
+	*/
+	enum StreamRecord {
+		STREAM_KEYFRAME = 1,
+		STREAM_ADDED,
+		STREAM_REMOVED,
+		STREAM_POSE,
+		STREAM_STATE,
+		STREAM_CLEARED,
+	};
+
+	// Encoded message or records, counted as stream memory
+	typedef Window::TrackedVector<unsigned char, Window::MEMORY_STREAM> StreamMessage;
+
+	// Winsock has to be started once before any socket is made
+	inline void startStreamSockets() {
+#ifdef _WIN32
+		static WSADATA data;
+		static int result = WSAStartup(MAKEWORD(2, 2), &data);
+
+		if (result != 0) {
+			throw std::runtime_error("[ERR] Window::Stream: can't start sockets");
+		}
+#endif
+	}
+
+	inline void closeStreamSocket(Window::StreamSocket socket) {
+#ifdef _WIN32
+		closesocket(socket);
+#else
+		::close(socket);
+#endif
+	}
+
+	/*!
+		\brief Make address of the Unix domain socket, throws if the path is too long
+		\param [in] path {Path of the socket file}
+	*/
+	inline sockaddr_un getStreamAddress(const char* path) {
+		sockaddr_un address;
+
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+
+		if (strlen(path) >= sizeof(address.sun_path)) {
+			throw std::runtime_error("[ERR] Window::Stream: socket path is too long");
+		}
+
+		strcpy(address.sun_path, path);
+
+		return address;
+	}
+
+	inline void putStreamNumber(Window::StreamMessage& message, unsigned long long value) {
+		do {
+			unsigned char byte = value & 0x7f;
+
+			value >>= 7;
+			message.push_back(byte | (value != 0 ? 0x80 : 0));
+		} while (value != 0);
+	}
+
+	// Signed numbers are zigzag encoded, so small negative ones stay short
+	inline void putStreamInteger(Window::StreamMessage& message, long long value) {
+		Window::putStreamNumber(message, ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63));
+	}
+
+	inline void putStreamAngle(Window::StreamMessage& message, double angle) {
+		unsigned long long bits;
+
+		memcpy(&bits, &angle, sizeof(bits));
+
+		for (int b = 0; b < 8; b++) {
+			message.push_back((unsigned char)(bits >> (b * 8)));
+		}
+	}
+
+	// Pose of the figure, the part of a figure record after vertices
+	inline void putStreamPose(Window::StreamMessage& message, Window::Figure& figure) {
+		Window::putStreamInteger(message, figure.getPosition().x);
+		Window::putStreamInteger(message, figure.getPosition().y);
+		Window::putStreamInteger(message, figure.getRadius());
+		Window::putStreamAngle(message, figure.getAngle());
+	}
+
+	/*!
+		\brief Statistics of the stream server
+		\version 1.0.0
+		\author Crinax
+	*/
+	struct StreamStats {
+		long long messages;
+		long long keyframes;
+		long long bytes_encoded;
+		long long bytes_sent;
+		long long resyncs;
+		long long viewers_lost;
+	};
+
+	/*!
+		\brief Streams changes of the scene to viewers over a Unix domain socket
+		\details Changes are collected from the scene as a listener and encoded by flush()
+			into one message for all viewers, so a message grows with the number of
+			changed figures, not with the scene. New viewers get a keyframe first, and
+			every viewer gets one each keyframe_interval messages.
+
+			Sockets are never waited for: each viewer has a queue of shared messages,
+			flush() sends what its socket takes. A viewer whose unsent changes would grow
+			past MAX_QUEUED_BYTES loses them and waits for a keyframe, which is encoded
+			only once its socket has taken everything queued before. So a slow viewer
+			skips changes, a stalled one costs one keyframe instead of one per flush, and
+			neither stalls the editor. Keyframes are not counted against the limit, they
+			may be larger than it in big scenes. Viewers see every flushed version or a
+			later keyframe.
+
+			Figures are only appended by the scene, so figures at and behind the count
+			the viewers know about are new and sent whole, without their pose changes.
+		\version 1.1.0
+		\author Crinax
+	*/
+	class StreamServer : public Window::SceneListener {
+		public:
+			// Unsent bytes of changes a viewer may fall behind by before it is resynced with a keyframe
+			static const size_t MAX_QUEUED_BYTES = 4 << 20;
+			// Messages between keyframes sent to all viewers, 0 means only to new and slow ones
+			static const int KEYFRAME_INTERVAL = 256;
+
+			/*!
+				\brief Main constructor for class, listens on the socket and follows the scene
+				\param [in] scene {The scene, edited by the thread calling flush()}
+				\param [in] path {Path of the socket file, an old file is replaced}
+				\param [in] keyframe_interval {Messages between keyframes to all viewers}
+			*/
+			StreamServer(Window::Scene& scene, const char* path, int keyframe_interval = Window::StreamServer::KEYFRAME_INTERVAL) : scene(scene) {
+				sockaddr_un address = Window::getStreamAddress(path);
+
+				Window::startStreamSockets();
+				this->server_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+
+				if (this->server_socket == Window::NO_STREAM_SOCKET) {
+					throw std::runtime_error("[ERR] Window::StreamServer: can't create socket");
+				}
+
+#ifdef _WIN32
+				DeleteFileA(path);
+#else
+				unlink(path);
+#endif
+
+				if (bind(this->server_socket, (sockaddr*)&address, sizeof(address)) != 0
+					|| listen(this->server_socket, 16) != 0
+					|| !this->setNonBlocking(this->server_socket)) {
+					Window::closeStreamSocket(this->server_socket);
+					throw std::runtime_error("[ERR] Window::StreamServer: can't listen on the socket");
+				}
+
+				this->path = path;
+				this->keyframe_interval = keyframe_interval;
+				this->messages_since_keyframe = 0;
+				this->version = 0;
+				this->sent_count = scene.countElements();
+				this->is_pose_dirty.assign(this->sent_count, false);
+				this->is_state_dirty = false;
+				this->stats = {};
+				this->scene.addListener(this);
+			}
+
+			StreamServer(const StreamServer&) = delete;
+			StreamServer& operator=(const StreamServer&) = delete;
+
+			~StreamServer() {
+				this->scene.removeListener(this);
+
+				for (size_t v = 0; v < this->viewers.size(); v++) {
+					Window::closeStreamSocket(this->viewers[v].socket);
+				}
+
+				Window::closeStreamSocket(this->server_socket);
+
+#ifdef _WIN32
+				DeleteFileA(this->path.c_str());
+#else
+				unlink(this->path.c_str());
+#endif
+			}
+
+			/*!
+				\brief Send changes made since the previous flush, editor thread only
+				\details Also accepts new viewers and sends what the sockets take. Costs
+					O(1) when nothing changed and no viewer waits for a keyframe, so it
+					may be called from a timer to drain the queues.
+			*/
+			void flush() {
+				// Poses of children are recomputed lazily, their changes come from here
+				this->scene.updateWorldTransforms();
+				this->acceptViewers();
+
+				std::shared_ptr<const Window::StreamMessage> delta;
+				bool is_keyframe_due = false;
+
+				if (this->hasChanges()) {
+					delta = this->encodeDelta();
+					this->messages_since_keyframe++;
+					is_keyframe_due = this->keyframe_interval > 0 && this->messages_since_keyframe >= this->keyframe_interval;
+				}
+
+				for (size_t v = 0; v < this->viewers.size(); v++) {
+					StreamViewer& viewer = this->viewers[v];
+
+					if (is_keyframe_due) {
+						this->requestKeyframe(viewer);
+					}
+
+					// The keyframe the viewer waits for will have these changes
+					if (viewer.needs_keyframe || !delta) {
+						continue;
+					}
+
+					if (viewer.unsent_bytes + delta->size() > Window::StreamServer::MAX_QUEUED_BYTES) {
+						this->requestKeyframe(viewer);
+						this->stats.resyncs++;
+						continue;
+					}
+
+					this->enqueue(viewer, delta, true);
+				}
+
+				if (is_keyframe_due) {
+					this->messages_since_keyframe = 0;
+				}
+
+				this->sendQueued();
+				this->queueKeyframes();
+			}
+
+			int countViewers() {
+				return (int)this->viewers.size();
+			}
+
+			// Returns bytes queued for all viewers and not sent yet
+			size_t countQueuedBytes() {
+				size_t bytes = 0;
+
+				for (size_t v = 0; v < this->viewers.size(); v++) {
+					bytes += this->viewers[v].queued_bytes - this->viewers[v].offset;
+				}
+
+				return bytes;
+			}
+
+			Window::StreamStats getStats() {
+				return this->stats;
+			}
+
+			void onFigureAdded(int /* index */) {}
+
+			void onFigureRemoved(int index) {
+				// Active and selected indices may shift without a state change
+				this->is_state_dirty = true;
+
+				if (index >= this->sent_count) {
+					return;
+				}
+
+				this->pending.push_back(Window::STREAM_REMOVED);
+				Window::putStreamNumber(this->pending, index);
+				this->sent_count--;
+				this->is_pose_dirty.erase(this->is_pose_dirty.begin() + index);
+
+				size_t kept = 0;
+
+				for (size_t d = 0; d < this->dirty_poses.size(); d++) {
+					int dirty = this->dirty_poses[d];
+
+					if (dirty != index) {
+						this->dirty_poses[kept++] = dirty > index ? dirty - 1 : dirty;
+					}
+				}
+
+				this->dirty_poses.resize(kept);
+			}
+
+			void onFigureChanged(int index) {
+				if (index < this->sent_count && !this->is_pose_dirty[index]) {
+					this->is_pose_dirty[index] = true;
+					this->dirty_poses.push_back(index);
+				}
+			}
+
+			void onFigureStateChanged(int /* index */) {
+				this->is_state_dirty = true;
+			}
+
+			void onSceneCleared() {
+				this->pending.clear();
+				this->pending.push_back(Window::STREAM_CLEARED);
+				this->sent_count = 0;
+				this->is_pose_dirty.clear();
+				this->dirty_poses.clear();
+				this->is_state_dirty = true;
+			}
+
+		protected:
+			// Message waiting for the socket of a viewer
+			struct QueuedMessage {
+				std::shared_ptr<const Window::StreamMessage> message;
+				// Deltas count against MAX_QUEUED_BYTES, the header and keyframes don't
+				bool is_delta;
+			};
+
+			// Connected viewer and messages waiting for its socket
+			struct StreamViewer {
+				Window::StreamSocket socket;
+				std::deque<QueuedMessage> queue;
+				// Bytes of the first message already sent
+				size_t offset;
+				size_t queued_bytes;
+				// Bytes of deltas not started to be sent
+				size_t unsent_bytes;
+				bool needs_keyframe;
+				bool has_magic;
+			};
+
+			Window::Scene& scene;
+			std::string path;
+			Window::StreamSocket server_socket;
+			std::vector<StreamViewer> viewers;
+			// Removals and clears since the previous flush, in the order they happened
+			Window::StreamMessage pending;
+			// Figures [0, sent_count) are known to the viewers, in the current numbering
+			int sent_count;
+			Window::TrackedVector<bool, Window::MEMORY_STREAM> is_pose_dirty;
+			Window::TrackedVector<int, Window::MEMORY_STREAM> dirty_poses;
+			bool is_state_dirty;
+			int keyframe_interval;
+			int messages_since_keyframe;
+			unsigned long long version;
+			Window::StreamStats stats;
+
+			bool hasChanges() {
+				return !this->pending.empty()
+					|| !this->dirty_poses.empty()
+					|| this->is_state_dirty
+					|| this->sent_count != this->scene.countElements();
+			}
+
+			bool setNonBlocking(Window::StreamSocket socket) {
+#ifdef _WIN32
+				u_long is_non_blocking = 1;
+
+				return ioctlsocket(socket, FIONBIO, &is_non_blocking) == 0;
+#else
+				int flags = fcntl(socket, F_GETFL, 0);
+
+				return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+			}
+
+			bool isWouldBlock() {
+#ifdef _WIN32
+				return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+				return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+			}
+
+			// Stream header, queued before the first keyframe of a viewer
+			const std::shared_ptr<const Window::StreamMessage>& getMagic() {
+				static const std::shared_ptr<const Window::StreamMessage> magic = std::make_shared<const Window::StreamMessage>(
+					Window::stream_magic,
+					Window::stream_magic + sizeof(Window::stream_magic)
+				);
+
+				return magic;
+			}
+
+			// New viewers get nothing until the next flush queues their keyframe
+			void acceptViewers() {
+				while (true) {
+					Window::StreamSocket socket = accept(this->server_socket, NULL, NULL);
+
+					if (socket == Window::NO_STREAM_SOCKET) {
+						return;
+					}
+
+#ifdef SO_NOSIGPIPE
+					int is_no_sigpipe = 1;
+
+					setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &is_no_sigpipe, sizeof(is_no_sigpipe));
+#endif
+
+					if (!this->setNonBlocking(socket)) {
+						Window::closeStreamSocket(socket);
+						continue;
+					}
+
+					this->viewers.push_back({ socket, {}, 0, 0, 0, true, false });
+				}
+			}
+
+			void enqueue(StreamViewer& viewer, const std::shared_ptr<const Window::StreamMessage>& message, bool is_delta) {
+				viewer.queue.push_back({ message, is_delta });
+				viewer.queued_bytes += message->size();
+				viewer.unsent_bytes += is_delta ? message->size() : 0;
+			}
+
+			// Drop queued messages, except the one being sent, which the viewer has to finish
+			void dropUnsent(StreamViewer& viewer) {
+				size_t kept = viewer.offset > 0 ? 1 : 0;
+
+				while (viewer.queue.size() > kept) {
+					viewer.queued_bytes -= viewer.queue.back().message->size();
+					viewer.queue.pop_back();
+				}
+
+				viewer.unsent_bytes = 0;
+			}
+
+			// Keyframe replaces everything the viewer hasn't started to receive
+			void requestKeyframe(StreamViewer& viewer) {
+				this->dropUnsent(viewer);
+				viewer.needs_keyframe = true;
+			}
+
+			// Queue one shared keyframe for viewers which wait for it and have sent everything else
+			void queueKeyframes() {
+				std::shared_ptr<const Window::StreamMessage> keyframe;
+
+				for (size_t v = 0; v < this->viewers.size(); v++) {
+					StreamViewer& viewer = this->viewers[v];
+
+					if (!viewer.needs_keyframe || !viewer.queue.empty()) {
+						continue;
+					}
+
+					if (!keyframe) {
+						keyframe = this->encodeKeyframe();
+					}
+
+					if (!viewer.has_magic) {
+						this->enqueue(viewer, this->getMagic(), false);
+						viewer.has_magic = true;
+					}
+
+					this->enqueue(viewer, keyframe, false);
+					viewer.needs_keyframe = false;
+				}
+
+				if (keyframe) {
+					this->sendQueued();
+				}
+			}
+
+			// Send what the sockets take without waiting, viewers with broken sockets are dropped
+			void sendQueued() {
+				size_t kept = 0;
+
+				for (size_t v = 0; v < this->viewers.size(); v++) {
+					StreamViewer& viewer = this->viewers[v];
+					bool is_lost = false;
+
+					while (!viewer.queue.empty()) {
+						const Window::StreamMessage& message = *viewer.queue.front().message;
+#ifdef _WIN32
+						int sent = ::send(viewer.socket, (const char*)message.data() + viewer.offset, (int)(message.size() - viewer.offset), 0);
+#elif defined(MSG_NOSIGNAL)
+						ssize_t sent = ::send(viewer.socket, message.data() + viewer.offset, message.size() - viewer.offset, MSG_NOSIGNAL);
+#else
+						ssize_t sent = ::send(viewer.socket, message.data() + viewer.offset, message.size() - viewer.offset, 0);
+#endif
+
+						if (sent <= 0) {
+							is_lost = sent < 0 && !this->isWouldBlock();
+							break;
+						}
+
+						if (viewer.offset == 0 && viewer.queue.front().is_delta) {
+							viewer.unsent_bytes -= message.size();
+						}
+
+						viewer.offset += sent;
+						this->stats.bytes_sent += sent;
+
+						if (viewer.offset == message.size()) {
+							viewer.queued_bytes -= message.size();
+							viewer.queue.pop_front();
+							viewer.offset = 0;
+						}
+					}
+
+					if (is_lost) {
+						Window::closeStreamSocket(viewer.socket);
+						this->stats.viewers_lost++;
+						continue;
+					}
+
+					if (kept != v) {
+						this->viewers[kept] = std::move(viewer);
+					}
+
+					kept++;
+				}
+
+				this->viewers.resize(kept);
+			}
+
+			std::shared_ptr<Window::StreamMessage> newMessage() {
+				std::shared_ptr<Window::StreamMessage> message = std::allocate_shared<Window::StreamMessage>(
+					Window::TrackedAllocator<Window::StreamMessage, Window::MEMORY_STREAM>()
+				);
+
+				message->resize(4);
+				Window::putStreamNumber(*message, this->version);
+
+				return message;
+			}
+
+			void finishMessage(Window::StreamMessage& message) {
+				size_t size = message.size() - 4;
+
+				for (int b = 0; b < 4; b++) {
+					message[b] = (unsigned char)(size >> (b * 8));
+				}
+
+				this->stats.messages++;
+				this->stats.bytes_encoded += message.size();
+			}
+
+			// Changes since the previous flush, the viewers know figures [0, sent_count) after it
+			std::shared_ptr<const Window::StreamMessage> encodeDelta() {
+				int element_count = this->scene.countElements();
+
+				this->version++;
+
+				std::shared_ptr<Window::StreamMessage> message = this->newMessage();
+
+				message->insert(message->end(), this->pending.begin(), this->pending.end());
+
+				for (size_t d = 0; d < this->dirty_poses.size(); d++) {
+					int index = this->dirty_poses[d];
+					Window::Figure figure = this->scene.getFigure(index);
+
+					message->push_back(Window::STREAM_POSE);
+					Window::putStreamNumber(*message, index);
+					Window::putStreamPose(*message, figure);
+					this->is_pose_dirty[index] = false;
+				}
+
+				for (int i = this->sent_count; i < element_count; i++) {
+					Window::Figure figure = this->scene.getFigure(i);
+
+					message->push_back(Window::STREAM_ADDED);
+					Window::putStreamNumber(*message, figure.countVertices());
+					Window::putStreamPose(*message, figure);
+				}
+
+				if (this->is_state_dirty) {
+					this->putState(*message);
+				}
+
+				this->finishMessage(*message);
+				this->pending.clear();
+				this->dirty_poses.clear();
+				this->sent_count = element_count;
+				this->is_pose_dirty.resize(element_count, false);
+				this->is_state_dirty = false;
+
+				return message;
+			}
+
+			// Whole scene at the current version
+			std::shared_ptr<const Window::StreamMessage> encodeKeyframe() {
+				int element_count = this->scene.countElements();
+				std::shared_ptr<Window::StreamMessage> message = this->newMessage();
+
+				message->push_back(Window::STREAM_KEYFRAME);
+				Window::putStreamNumber(*message, element_count);
+
+				for (int i = 0; i < element_count; i++) {
+					Window::Figure figure = this->scene.getFigure(i);
+
+					Window::putStreamNumber(*message, figure.countVertices());
+					Window::putStreamPose(*message, figure);
+				}
+
+				this->putState(*message);
+				this->finishMessage(*message);
+				this->stats.keyframes++;
+
+				return message;
+			}
+
+			void putState(Window::StreamMessage& message) {
+				const Window::TrackedVector<unsigned long long, Window::MEMORY_SCENE>& mask = this->scene.getHighlightMask();
+				size_t words = 0;
+
+				for (size_t w = 0; w < mask.size(); w++) {
+					words += mask[w] != 0 ? 1 : 0;
+				}
+
+				message.push_back(Window::STREAM_STATE);
+				Window::putStreamNumber(message, this->scene.getActiveFigureIndex() + 1);
+				Window::putStreamNumber(message, this->scene.getSelectedFigureIndex() + 1);
+				Window::putStreamNumber(message, this->scene.isBlocked() ? 1 : 0);
+				Window::putStreamNumber(message, words);
+
+				size_t next = 0;
+
+				for (size_t w = 0; w < mask.size(); w++) {
+					if (mask[w] != 0) {
+						Window::putStreamNumber(message, w - next);
+						Window::putStreamNumber(message, mask[w]);
+						next = w + 1;
+					}
+				}
+			}
+	};
+
+	/*!
+		\brief Copy of the scene rebuilt from stream messages by a viewer
+		\version 1.0.0
+		\author Crinax
+	*/
+	class StreamMirror {
+		public:
+			/*!
+				\brief Main constructor for class
+				\param [in] library {Templates of figures, shared with other scenes}
+			*/
+			StreamMirror(Window::TemplateLibrary& library = Window::TemplateLibrary::getShared()) : library(library) {
+				this->active_figure = -1;
+				this->selected_figure = -1;
+				this->is_blocked = false;
+				this->version = 0;
+				this->keyframes = 0;
+
+				for (int kind = 0; kind <= Window::Figure::MAX_VERTICES; kind++) {
+					this->templates[kind] = NULL;
+				}
+			}
+
+			StreamMirror(const StreamMirror&) = delete;
+			StreamMirror& operator=(const StreamMirror&) = delete;
+
+			~StreamMirror() {
+				for (int kind = 0; kind <= Window::Figure::MAX_VERTICES; kind++) {
+					if (this->templates[kind] != NULL) {
+						this->library.release(this->templates[kind]);
+					}
+				}
+			}
+
+			/*!
+				\brief Apply the payload of one message, throws if it is broken
+				\param [in] payload {The message without its size}
+				\param [in] size {Size of the payload}
+			*/
+			void apply(const unsigned char* payload, size_t size) {
+				this->data = payload;
+				this->size = size;
+				this->position = 0;
+				this->version = this->readNumber();
+
+				while (this->position < this->size) {
+					unsigned char record = this->data[this->position++];
+
+					switch (record) {
+						case Window::STREAM_KEYFRAME: {
+							unsigned long long count = this->readNumber();
+
+							if (count > this->size) {
+								this->fail();
+							}
+
+							this->figures.clear();
+							this->figures.reserve(count);
+
+							for (unsigned long long i = 0; i < count; i++) {
+								this->figures.push_back(this->readFigure());
+							}
+
+							this->keyframes++;
+							break;
+						}
+
+						case Window::STREAM_ADDED:
+							this->figures.push_back(this->readFigure());
+							break;
+
+						case Window::STREAM_REMOVED:
+							this->figures.erase(this->figures.begin() + this->readIndex());
+							break;
+
+						case Window::STREAM_POSE: {
+							Window::Figure& figure = this->figures[this->readIndex()];
+
+							figure = this->readPose(figure.getTemplate());
+							break;
+						}
+
+						case Window::STREAM_STATE:
+							this->readState();
+							break;
+
+						case Window::STREAM_CLEARED:
+							this->figures.clear();
+							this->highlight_mask.clear();
+							break;
+
+						default:
+							this->fail();
+					}
+				}
+			}
+
+			int countElements() {
+				return (int)this->figures.size();
+			}
+
+			// Returns the figure by index
+			Window::Figure getFigure(int index) {
+				if (index >= (int)this->figures.size()) {
+					throw std::out_of_range("[ERR] Window::StreamMirror: index greeter than max possible figures");
+				}
+
+				return this->figures[index];
+			}
+
+			int getActiveFigureIndex() {
+				return this->active_figure;
+			}
+
+			int getSelectedFigureIndex() {
+				return this->selected_figure;
+			}
+
+			bool isBlocked() {
+				return this->is_blocked;
+			}
+
+			// Returns version of the scene the last message brought
+			unsigned long long getVersion() {
+				return this->version;
+			}
+
+			// Returns number of keyframes applied
+			long long countKeyframes() {
+				return this->keyframes;
+			}
+
+			/*!
+				\brief Returns flags of figures [first, first + count) at once, see Scene::getFigureStates
+				\param [in] first {Index of the first figure}
+				\param [in] count {Number of figures}
+				\param [out] states {Flags of the figures, resized to count}
+			*/
+			void getFigureStates(int first, int count, Window::FigureStates& states) {
+				states.assign(count, 0);
+
+				for (size_t word = first / 64; word < this->highlight_mask.size() && (int)(word * 64) < first + count; word++) {
+					for (int bit = 0; bit < 64 && this->highlight_mask[word] != 0; bit++) {
+						int index = (int)(word * 64) + bit - first;
+
+						if ((this->highlight_mask[word] >> bit & 1) && index >= 0 && index < count) {
+							states[index] |= Window::Scene::FIGURE_ACTIVE;
+						}
+					}
+				}
+
+				if (this->active_figure >= first && this->active_figure < first + count) {
+					states[this->active_figure - first] |= Window::Scene::FIGURE_ACTIVE;
+				}
+
+				if (this->selected_figure >= first && this->selected_figure < first + count) {
+					states[this->selected_figure - first] |= Window::Scene::FIGURE_SELECTED;
+				}
+			}
+
+		protected:
+			Window::TemplateLibrary& library;
+			const Window::FigureTemplate* templates[Window::Figure::MAX_VERTICES + 1];
+			Window::TrackedVector<Window::Figure, Window::MEMORY_STREAM> figures;
+			Window::TrackedVector<unsigned long long, Window::MEMORY_STREAM> highlight_mask;
+			int active_figure;
+			int selected_figure;
+			bool is_blocked;
+			unsigned long long version;
+			long long keyframes;
+			// Message being applied
+			const unsigned char* data;
+			size_t size;
+			size_t position;
+
+			void fail() {
+				throw std::runtime_error("[ERR] Window::StreamMirror: broken message");
+			}
+
+			unsigned long long readNumber() {
+				unsigned long long value = 0;
+
+				for (int shift = 0; shift < 64; shift += 7) {
+					if (this->position >= this->size) {
+						this->fail();
+					}
+
+					unsigned char byte = this->data[this->position++];
+
+					value |= (unsigned long long)(byte & 0x7f) << shift;
+
+					if (!(byte & 0x80)) {
+						return value;
+					}
+				}
+
+				this->fail();
+				return 0;
+			}
+
+			long long readInteger() {
+				unsigned long long value = this->readNumber();
+
+				return (long long)(value >> 1) ^ -(long long)(value & 1);
+			}
+
+			// Index of an existing figure
+			size_t readIndex() {
+				unsigned long long index = this->readNumber();
+
+				if (index >= this->figures.size()) {
+					this->fail();
+				}
+
+				return (size_t)index;
+			}
+
+			Window::Figure readPose(const Window::FigureTemplate* shape) {
+				Window::Point center;
+
+				center.x = (int)this->readInteger();
+				center.y = (int)this->readInteger();
+
+				int radius = (int)this->readInteger();
+				unsigned long long bits = 0;
+				double angle;
+
+				if (this->size - this->position < 8) {
+					this->fail();
+				}
+
+				for (int b = 0; b < 8; b++) {
+					bits |= (unsigned long long)this->data[this->position++] << (b * 8);
+				}
+
+				memcpy(&angle, &bits, sizeof(angle));
+
+				return Window::Figure(shape, center, radius, angle);
+			}
+
+			Window::Figure readFigure() {
+				unsigned long long vertices_number = this->readNumber();
+
+				if (vertices_number > (unsigned long long)Window::Figure::MAX_VERTICES) {
+					this->fail();
+				}
+
+				if (this->templates[vertices_number] == NULL) {
+					this->templates[vertices_number] = this->library.acquire((int)vertices_number);
+				}
+
+				return this->readPose(this->templates[vertices_number]);
+			}
+
+			void readState() {
+				this->active_figure = (int)this->readNumber() - 1;
+				this->selected_figure = (int)this->readNumber() - 1;
+				this->is_blocked = this->readNumber() != 0;
+
+				unsigned long long words = this->readNumber();
+				size_t next = 0;
+
+				this->highlight_mask.clear();
+
+				for (unsigned long long w = 0; w < words; w++) {
+					size_t word = next + (size_t)this->readNumber();
+
+					if (word > this->figures.size() / 64) {
+						this->fail();
+					}
+
+					this->highlight_mask.resize(word + 1, 0);
+					this->highlight_mask[word] = this->readNumber();
+					next = word + 1;
+				}
+			}
+	};
+
+	/*!
+		\brief Connection of a viewer to the stream server
+		\version 1.0.0
+		\author Crinax
+	*/
+	class StreamClient {
+		public:
+			/*!
+				\brief Main constructor for class, connects to the server or throws
+				\param [in] path {Path of the socket file}
+			*/
+			StreamClient(const char* path) {
+				sockaddr_un address = Window::getStreamAddress(path);
+
+				Window::startStreamSockets();
+				this->client_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+
+				if (this->client_socket == Window::NO_STREAM_SOCKET) {
+					throw std::runtime_error("[ERR] Window::StreamClient: can't create socket");
+				}
+
+				if (connect(this->client_socket, (sockaddr*)&address, sizeof(address)) != 0) {
+					Window::closeStreamSocket(this->client_socket);
+					throw std::runtime_error("[ERR] Window::StreamClient: can't connect");
+				}
+
+				this->start = 0;
+				this->received = 0;
+				this->has_magic = false;
+			}
+
+			StreamClient(const StreamClient&) = delete;
+			StreamClient& operator=(const StreamClient&) = delete;
+
+			~StreamClient() {
+				Window::closeStreamSocket(this->client_socket);
+			}
+
+			/*!
+				\brief Wait for data and apply every complete message to the mirror
+				\param [in] mirror {The mirror}
+				\return Number of applied messages, -1 when the server has closed the stream
+			*/
+			int receive(Window::StreamMirror& mirror) {
+				unsigned char bytes[64 * 1024];
+#ifdef _WIN32
+				int size = ::recv(this->client_socket, (char*)bytes, sizeof(bytes), 0);
+#else
+				ssize_t size = ::recv(this->client_socket, bytes, sizeof(bytes), 0);
+#endif
+
+				if (size <= 0) {
+					return -1;
+				}
+
+				this->received += size;
+				this->buffer.insert(this->buffer.end(), bytes, bytes + size);
+
+				if (!this->has_magic) {
+					if (this->buffer.size() < sizeof(Window::stream_magic)) {
+						return 0;
+					}
+
+					if (memcmp(this->buffer.data(), Window::stream_magic, sizeof(Window::stream_magic)) != 0) {
+						throw std::runtime_error("[ERR] Window::StreamClient: not a stream or unknown version");
+					}
+
+					this->start = sizeof(Window::stream_magic);
+					this->has_magic = true;
+				}
+
+				int applied = 0;
+
+				while (this->buffer.size() - this->start >= 4) {
+					const unsigned char* header = this->buffer.data() + this->start;
+					size_t message_size = header[0] | header[1] << 8 | header[2] << 16 | (size_t)header[3] << 24;
+
+					if (this->buffer.size() - this->start - 4 < message_size) {
+						break;
+					}
+
+					mirror.apply(header + 4, message_size);
+					this->start += 4 + message_size;
+					applied++;
+				}
+
+				// Applied messages are dropped once they are most of the buffer
+				if (this->start > this->buffer.size() / 2) {
+					this->buffer.erase(this->buffer.begin(), this->buffer.begin() + this->start);
+					this->start = 0;
+				}
+
+				return applied;
+			}
+
+			// Returns bytes received from the server
+			long long countReceivedBytes() {
+				return this->received;
+			}
+
+		protected:
+			Window::StreamSocket client_socket;
+			Window::StreamMessage buffer;
+			size_t start;
+			long long received;
+			bool has_magic;
+	};
+};
+
+#endif
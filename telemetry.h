@@ -0,0 +1,409 @@
+#ifndef PAINTING_TELEMETRY_H
+#define PAINTING_TELEMETRY_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <new>
+#include <atomic>
+#include <vector>
+
+namespace Window {
+	// Owners of tracked memory, renderer resources like GDI pens are counted by number
+	enum MemorySubsystem {
+		MEMORY_FIGURES,
+		MEMORY_TEMPLATES,
+		MEMORY_SCENE,
+		MEMORY_OVERLAPS,
+		MEMORY_HIERARCHY,
+		MEMORY_SNAPSHOTS,
+		MEMORY_RENDERER,
+		MEMORY_EXPORT,
+		MEMORY_STREAM,
+		MEMORY_NEAREST,
+		MEMORY_SUBSYSTEMS,
+	};
+
+	// Names of subsystems in the report, indexed by MemorySubsystem
+	const char* const memory_subsystem_names[] = {
+		"figures",
+		"templates",
+		"scene",
+		"overlaps",
+		"hierarchy",
+		"snapshots",
+		"renderer",
+		"export",
+		"stream",
+		"nearest",
+	};
+
+	/*!
+		\brief Functions the tracked memory is taken from
+		\details Size of the block is passed back on deallocate, so the hook needs no headers.
+			Default one is the global operator new and delete.
+		\version 1.0.0
+		\author Crinax
+	*/
+	struct AllocatorHook {
+		void* (*allocate)(size_t bytes);
+		void (*deallocate)(void* memory, size_t bytes);
+	};
+
+	/*!
+		\brief Counters of one subsystem
+		\details Bytes and resources are live ones, peaks are their high-water marks.
+			Frame numbers are allocations between beginFrame() and endFrame().
+		\version 1.0.0
+		\author Crinax
+	*/
+	struct MemoryCounters {
+		long long bytes;
+		long long peak_bytes;
+		long long allocations;
+		long long deallocations;
+		long long resources;
+		long long peak_resources;
+		long long frame_allocations;
+		long long max_frame_allocations;
+	};
+
+	/*!
+		\brief Memory of the scene and the renderer by subsystem
+		\details Tracked containers and arenas allocate through allocate() and deallocate(),
+			which call the hook and, once enable() is called, count bytes and allocations.
+			Tracking is off by default and then costs one relaxed load per allocation.
+			Counting starts at enable(), so enable it before scenes are created, otherwise
+			freeing memory allocated earlier makes live bytes too low.
+
+			Frames are marked with beginFrame() and endFrame(), every frame with a tracked
+			allocation is counted as churn. Zero churn frames show that tracked containers
+			don't allocate in the steady state, plain std containers are not counted.
+		\version 1.0.0
+		\author Crinax
+	*/
+	class MemoryTelemetry {
+		public:
+			// Telemetry of the process, all tracked containers report here
+			static Window::MemoryTelemetry& getShared() {
+				static Window::MemoryTelemetry telemetry;
+
+				return telemetry;
+			}
+
+			MemoryTelemetry(const MemoryTelemetry&) = delete;
+			MemoryTelemetry& operator=(const MemoryTelemetry&) = delete;
+
+			void enable() {
+				this->is_enabled.store(true, std::memory_order_relaxed);
+			}
+
+			void disable() {
+				this->is_enabled.store(false, std::memory_order_relaxed);
+			}
+
+			bool isEnabled() {
+				return this->is_enabled.load(std::memory_order_relaxed);
+			}
+
+			/*!
+				\brief Replace functions the memory is taken from
+				\details Memory is always returned to the current hook, so set it before
+					anything is allocated
+				\param [in] hook {New hook}
+			*/
+			void setHook(Window::AllocatorHook hook) {
+				this->hook = hook;
+			}
+
+			/*!
+				\brief Allocate memory for the subsystem, throws std::bad_alloc if there is none
+				\param [in] bytes {Size of the block}
+				\param [in] subsystem {Owner of the block}
+			*/
+			void* allocate(size_t bytes, Window::MemorySubsystem subsystem) {
+				void* memory = this->hook.allocate(bytes);
+
+				if (this->isEnabled()) {
+					Counters& counters = this->counters[subsystem];
+
+					counters.allocations.fetch_add(1, std::memory_order_relaxed);
+					this->raise(counters.bytes, counters.peak_bytes, (long long)bytes);
+
+					if (this->is_in_frame.load(std::memory_order_relaxed)) {
+						counters.frame_allocations.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+
+				return memory;
+			}
+
+			/*!
+				\brief Return memory taken with allocate
+				\param [in] memory {The block}
+				\param [in] bytes {Size the block was allocated with}
+				\param [in] subsystem {Owner of the block}
+			*/
+			void deallocate(void* memory, size_t bytes, Window::MemorySubsystem subsystem) {
+				if (memory == NULL) {
+					return;
+				}
+
+				if (this->isEnabled()) {
+					Counters& counters = this->counters[subsystem];
+
+					counters.deallocations.fetch_add(1, std::memory_order_relaxed);
+					counters.bytes.fetch_sub((long long)bytes, std::memory_order_relaxed);
+				}
+
+				this->hook.deallocate(memory, bytes);
+			}
+
+			/*!
+				\brief Count resources which are not heap memory, like pens of the window
+				\param [in] subsystem {Owner of the resources}
+				\param [in] delta {Number of created resources, negative for deleted ones}
+			*/
+			void countResources(Window::MemorySubsystem subsystem, int delta) {
+				if (!this->isEnabled()) {
+					return;
+				}
+
+				Counters& counters = this->counters[subsystem];
+
+				if (delta > 0) {
+					counters.allocations.fetch_add(delta, std::memory_order_relaxed);
+
+					if (this->is_in_frame.load(std::memory_order_relaxed)) {
+						counters.frame_allocations.fetch_add(delta, std::memory_order_relaxed);
+					}
+				} else {
+					counters.deallocations.fetch_add(-delta, std::memory_order_relaxed);
+				}
+
+				this->raise(counters.resources, counters.peak_resources, delta);
+			}
+
+			// Start counting allocations of a frame
+			void beginFrame() {
+				for (int s = 0; s < Window::MEMORY_SUBSYSTEMS; s++) {
+					this->counters[s].frame_allocations.store(0, std::memory_order_relaxed);
+				}
+
+				this->is_in_frame.store(true, std::memory_order_relaxed);
+			}
+
+			// Finish the frame, returns number of allocations made during it
+			long long endFrame() {
+				long long allocations = 0;
+
+				this->is_in_frame.store(false, std::memory_order_relaxed);
+
+				if (!this->isEnabled()) {
+					return 0;
+				}
+
+				for (int s = 0; s < Window::MEMORY_SUBSYSTEMS; s++) {
+					Counters& counters = this->counters[s];
+					long long frame_allocations = counters.frame_allocations.load(std::memory_order_relaxed);
+
+					if (frame_allocations > counters.max_frame_allocations.load(std::memory_order_relaxed)) {
+						counters.max_frame_allocations.store(frame_allocations, std::memory_order_relaxed);
+					}
+
+					allocations += frame_allocations;
+				}
+
+				this->frames++;
+				this->churn_frames += allocations > 0 ? 1 : 0;
+				this->last_frame_allocations = allocations;
+
+				return allocations;
+			}
+
+			// Returns counters of the subsystem, taken one by one while others may allocate
+			Window::MemoryCounters getCounters(Window::MemorySubsystem subsystem) {
+				Counters& counters = this->counters[subsystem];
+
+				return {
+					counters.bytes.load(std::memory_order_relaxed),
+					counters.peak_bytes.load(std::memory_order_relaxed),
+					counters.allocations.load(std::memory_order_relaxed),
+					counters.deallocations.load(std::memory_order_relaxed),
+					counters.resources.load(std::memory_order_relaxed),
+					counters.peak_resources.load(std::memory_order_relaxed),
+					counters.frame_allocations.load(std::memory_order_relaxed),
+					counters.max_frame_allocations.load(std::memory_order_relaxed),
+				};
+			}
+
+			// Returns number of finished frames and of those with tracked allocations
+			long long countFrames() {
+				return this->frames;
+			}
+
+			long long countChurnFrames() {
+				return this->churn_frames;
+			}
+
+			/*!
+				\brief Print counters of every subsystem and frame churn
+				\param [in] file {Where to print}
+			*/
+			void printReport(FILE* file) {
+				if (!this->isEnabled()) {
+					fprintf(file, "memory telemetry is disabled\n");
+					return;
+				}
+
+				long long bytes = 0;
+
+				fprintf(
+					file,
+					"%-10s %12s %12s %10s %10s %9s %9s %10s\n",
+					"memory",
+					"live KB",
+					"peak KB",
+					"allocs",
+					"frees",
+					"handles",
+					"peak hnd",
+					"max/frame"
+				);
+
+				for (int s = 0; s < Window::MEMORY_SUBSYSTEMS; s++) {
+					Window::MemoryCounters counters = this->getCounters((Window::MemorySubsystem)s);
+
+					bytes += counters.bytes;
+					fprintf(
+						file,
+						"%-10s %12.1f %12.1f %10lld %10lld %9lld %9lld %10lld\n",
+						Window::memory_subsystem_names[s],
+						counters.bytes / 1024.0,
+						counters.peak_bytes / 1024.0,
+						counters.allocations,
+						counters.deallocations,
+						counters.resources,
+						counters.peak_resources,
+						counters.max_frame_allocations
+					);
+				}
+
+				fprintf(file, "live total: %.1f KB\n", bytes / 1024.0);
+				fprintf(
+					file,
+					"frames: %lld, with tracked allocations: %lld, last one made %lld\n",
+					this->frames,
+					this->churn_frames,
+					this->last_frame_allocations
+				);
+			}
+
+		protected:
+			// Subsystems are on their own cache lines, since bulk building allocates from many threads
+			struct alignas(64) Counters {
+				std::atomic<long long> bytes;
+				std::atomic<long long> peak_bytes;
+				std::atomic<long long> allocations;
+				std::atomic<long long> deallocations;
+				std::atomic<long long> resources;
+				std::atomic<long long> peak_resources;
+				std::atomic<long long> frame_allocations;
+				std::atomic<long long> max_frame_allocations;
+			};
+
+			Window::AllocatorHook hook;
+			std::atomic<bool> is_enabled;
+			std::atomic<bool> is_in_frame;
+			Counters counters[Window::MEMORY_SUBSYSTEMS];
+			// Frames are marked by the thread drawing them
+			long long frames;
+			long long churn_frames;
+			long long last_frame_allocations;
+
+			MemoryTelemetry() {
+				this->hook = { Window::MemoryTelemetry::allocateDefault, Window::MemoryTelemetry::deallocateDefault };
+				this->is_enabled.store(false);
+				this->is_in_frame.store(false);
+				this->frames = 0;
+				this->churn_frames = 0;
+				this->last_frame_allocations = 0;
+
+				for (int s = 0; s < Window::MEMORY_SUBSYSTEMS; s++) {
+					Counters& counters = this->counters[s];
+
+					counters.bytes.store(0);
+					counters.peak_bytes.store(0);
+					counters.allocations.store(0);
+					counters.deallocations.store(0);
+					counters.resources.store(0);
+					counters.peak_resources.store(0);
+					counters.frame_allocations.store(0);
+					counters.max_frame_allocations.store(0);
+				}
+			}
+
+			// Add delta to the live value and raise its peak if it grew past it
+			void raise(std::atomic<long long>& value, std::atomic<long long>& peak, long long delta) {
+				long long live = value.fetch_add(delta, std::memory_order_relaxed) + delta;
+				long long known = peak.load(std::memory_order_relaxed);
+
+				while (live > known && !peak.compare_exchange_weak(known, live, std::memory_order_relaxed)) {
+				}
+			}
+
+			static void* allocateDefault(size_t bytes) {
+				return ::operator new(bytes);
+			}
+
+			static void deallocateDefault(void* memory, size_t /* bytes */) {
+				::operator delete(memory);
+			}
+	};
+
+	/*!
+		\brief Standard allocator routed through MemoryTelemetry
+		\details Containers of the scene and the renderer use it through TrackedVector,
+			so their memory is counted by subsystem.
+		\version 1.0.0
+		\author Crinax
+	*/
+	template <typename T, Window::MemorySubsystem Subsystem>
+	class TrackedAllocator {
+		public:
+			typedef T value_type;
+
+			template <typename U>
+			struct rebind {
+				typedef Window::TrackedAllocator<U, Subsystem> other;
+			};
+
+			TrackedAllocator() {}
+
+			template <typename U>
+			TrackedAllocator(const Window::TrackedAllocator<U, Subsystem>&) {}
+
+			T* allocate(size_t count) {
+				return (T*)Window::MemoryTelemetry::getShared().allocate(count * sizeof(T), Subsystem);
+			}
+
+			void deallocate(T* memory, size_t count) {
+				Window::MemoryTelemetry::getShared().deallocate(memory, count * sizeof(T), Subsystem);
+			}
+	};
+
+	template <typename T, typename U, Window::MemorySubsystem Subsystem>
+	bool operator==(const Window::TrackedAllocator<T, Subsystem>&, const Window::TrackedAllocator<U, Subsystem>&) {
+		return true;
+	}
+
+	template <typename T, typename U, Window::MemorySubsystem Subsystem>
+	bool operator!=(const Window::TrackedAllocator<T, Subsystem>&, const Window::TrackedAllocator<U, Subsystem>&) {
+		return false;
+	}
+
+	// Vector whose memory is counted for the subsystem
+	template <typename T, Window::MemorySubsystem Subsystem>
+	using TrackedVector = std::vector<T, Window::TrackedAllocator<T, Subsystem>>;
+};
+
+#endif
@@ -0,0 +1,68 @@
+/*!
+	\file
+	\brief Batches of generated figures are built by several threads
+	\details Every batch of newFiguresFrom has to reach the parallel threshold, and
+		figures built in parallel have to match figures created one by one. With one
+		hardware thread the figures are built serially, the threshold is still checked.
+
+		Build from the repository: g++ -std=c++17 -O2 -pthread -I. tests/bulk_insert.cpp -o bulk_insert
+	\author Crinax
+*/
+#include "check.h"
+#include "../scene.h"
+
+// Parameters of the i-th test figure
+Window::FigureSpec getSpec(size_t i) {
+	return {
+		{ (int)(i * 7919 % 4000), (int)(i * 104729 % 3000) },
+		(int)(i % 90) + 1,
+		3 + (int)(i % 8),
+		(double)(i % 628) / 100
+	};
+}
+
+int main() {
+	const size_t figure_count = 3 * Window::Scene::BULK_BATCH + 5;
+
+	CHECK(Window::Scene::countBuildThreads(Window::Scene::BULK_BATCH, 8) == 8);
+	CHECK(Window::Scene::countBuildThreads(Window::Scene::BULK_BATCH - 1, 8) == 1);
+	CHECK(Window::Scene::countBuildThreads(Window::Scene::BULK_BATCH, 1) == 1);
+
+	Window::Scene generated;
+	size_t next = 0;
+
+	generated.newFiguresFrom([&](Window::FigureSpec& spec) {
+		if (next == figure_count) {
+			return false;
+		}
+
+		spec = getSpec(next++);
+
+		return true;
+	}, figure_count);
+
+	CHECK(generated.countElements() == (int)figure_count);
+	CHECK(generated.getActiveFigureIndex() == (int)figure_count - 1);
+
+	Window::Scene created;
+
+	for (size_t i = 0; i < figure_count; i += 997) {
+		Window::FigureSpec spec = getSpec(i);
+
+		created.newFigure(spec.center, spec.radius, spec.vertices_number, spec.angle, true);
+
+		Window::Figure expected = created.getFigure(created.countElements() - 1);
+		Window::Figure figure = generated.getFigure((int)i);
+		Window::Point expected_vertices[Window::Figure::MAX_VERTICES];
+		Window::Point vertices[Window::Figure::MAX_VERTICES];
+		int count = figure.getVertices(vertices);
+
+		CHECK(count == expected.getVertices(expected_vertices));
+
+		for (int v = 0; v < count; v++) {
+			CHECK(vertices[v].x == expected_vertices[v].x && vertices[v].y == expected_vertices[v].y);
+		}
+	}
+
+	return CHECK_RESULT();
+}
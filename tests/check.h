@@ -0,0 +1,31 @@
+/*!
+	\file
+	\brief Minimal checks of the standalone tests
+	\details Every test is one translation unit with main(), built and run by hand,
+		its build line is in the header comment. A failed check prints the line and
+		makes the test exit with 1.
+	\author Crinax
+*/
+#ifndef PAINTING_CHECK_H
+#define PAINTING_CHECK_H
+
+#include <stdio.h>
+
+namespace Window {
+	inline int& countFailedChecks() {
+		static int failed = 0;
+		return failed;
+	}
+}
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			Window::countFailedChecks()++; \
+		} \
+	} while (0)
+
+#define CHECK_RESULT() (Window::countFailedChecks() == 0 ? (printf("OK\n"), 0) : 1)
+
+#endif
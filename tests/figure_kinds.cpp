@@ -0,0 +1,80 @@
+/*!
+	\file
+	\brief Vertices of FigureKind tables match the runtime sin/cos computation
+	\details For every N with a FigureKind the compile-time unit polygon is compared
+		with sin/cos of the same angles, and vertices of figures over a range of centers,
+		radii and angles are compared with the per-vertex computation figures used before
+		the tables. Truncation to int may differ only where the exact coordinate is within
+		rounding error of an integer.
+
+		Build from the repository: g++ -std=c++17 -O2 -I. tests/figure_kinds.cpp -o figure_kinds
+	\author Crinax
+*/
+#include "check.h"
+#include "../figure.h"
+
+// Coordinate of a vertex as computed at runtime for every vertex
+double getRuntimeCoord(int center, int radius, double angle, bool is_y) {
+	return center + radius * (is_y ? sin(angle) : cos(angle));
+}
+
+/*!
+	\brief Returns true if the table coordinate is the runtime one truncated
+	\details Where the runtime coordinate is within rounding error of an integer, either
+		may be truncated to the integer or next to it.
+	\param [in] coord {Coordinate from the table}
+	\param [in] runtime {Coordinate from sin/cos}
+	\param [in] scale {Magnitude of the center and the radius}
+*/
+bool isSameCoord(int coord, double runtime, double scale) {
+	if (coord == (int)runtime) {
+		return true;
+	}
+
+	return fabs(runtime - round(runtime)) < 1e-12 * scale && fabs(coord - round(runtime)) <= 1;
+}
+
+template <int N>
+long long checkKind() {
+	long long rounding_count = 0;
+
+	for (int i = 0; i < N; i++) {
+		CHECK(fabs(Window::FigureKind<N>::unit.cosines[i] - cos(2 * Window::pi * i / N)) < 1e-12);
+		CHECK(fabs(Window::FigureKind<N>::unit.sines[i] - sin(2 * Window::pi * i / N)) < 1e-12);
+	}
+
+	const Window::Point centers[] = { { 0, 0 }, { 317, -45 }, { -1000000, 2000000 } };
+	const int radii[] = { 0, 1, 2, 3, 5, 10, 17, 50, 99, 100, 255, 1000, 4096, 65535, 1000000 };
+
+	for (const Window::Point& center : centers) {
+		for (int radius : radii) {
+			for (int step = -2000; step <= 2000; step++) {
+				double angle = step * Window::rotate_angle / 8;
+				Window::Point vertex[N];
+				double scale = fabs((double)center.x) + fabs((double)center.y) + radius + 1;
+
+				Window::FigureKind<N>::getVertices(center, radius * cos(angle), radius * sin(angle), vertex);
+
+				for (int i = 0; i < N; i++) {
+					double vertex_angle = angle + 2 * Window::pi * i / N;
+					double x = getRuntimeCoord(center.x, radius, vertex_angle, false);
+					double y = getRuntimeCoord(center.y, radius, vertex_angle, true);
+
+					CHECK(isSameCoord(vertex[i].x, x, scale));
+					CHECK(isSameCoord(vertex[i].y, y, scale));
+					rounding_count += (vertex[i].x != (int)x) + (vertex[i].y != (int)y);
+				}
+			}
+		}
+	}
+
+	return rounding_count;
+}
+
+int main() {
+	long long rounding_count = checkKind<3>() + checkKind<4>() + checkKind<6>();
+
+	printf("coordinates truncated differently at integers: %lld\n", rounding_count);
+
+	return CHECK_RESULT();
+}
@@ -0,0 +1,110 @@
+/*!
+	\file
+	\brief One mutator and several readers of published snapshots
+	\details Every round the mutator stamps all figures of one chunk with the round
+		number and publishes. Readers check that each chunk they see carries a single
+		stamp, so no chunk is read while it is written, and that versions never go
+		back. Built with -fsanitize=address a reader of a freed snapshot or chunk
+		fails as well. Retired snapshots have to be reclaimed while readers run and
+		all of them once they stop.
+
+		Build from the repository: g++ -std=c++17 -O2 -pthread -I. tests/snapshot_stress.cpp -o snapshot_stress
+	\author Crinax
+*/
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "../snapshot.h"
+
+int main() {
+	const int chunk_count = 8;
+	const int round_count = 5000;
+	const int reader_count = 3;
+	Window::Scene scene;
+
+	for (int i = 0; i < chunk_count * Window::FigureChunk::SIZE; i++) {
+		scene.newFigure({ 0, i }, 5, 4, 0, true);
+	}
+
+	Window::SnapshotPublisher publisher(scene);
+	std::atomic<bool> is_done(false);
+	std::atomic<long long> reads(0);
+	std::atomic<long long> torn_chunks(0);
+	std::atomic<long long> late_versions(0);
+	std::vector<std::thread> readers;
+
+	publisher.publish();
+
+	for (int r = 0; r < reader_count; r++) {
+		readers.emplace_back([&]() {
+			int slot = publisher.registerReader();
+			unsigned long long last_version = 0;
+
+			while (!is_done.load()) {
+				Window::SnapshotGuard snapshot(publisher, slot);
+
+				if (snapshot->getVersion() < last_version) {
+					late_versions++;
+				}
+
+				last_version = snapshot->getVersion();
+
+				for (int c = 0; c < snapshot->countChunks(); c++) {
+					std::shared_ptr<const Window::FigureChunk> chunk = snapshot->getChunk(c);
+					Window::Figure first = chunk->figures[0];
+					int stamp = first.getPosition().x;
+
+					for (int i = 0; i < chunk->count; i++) {
+						Window::Figure figure = chunk->figures[i];
+						Window::Point position = figure.getPosition();
+
+						if (position.x != stamp || position.y != c * Window::FigureChunk::SIZE + i) {
+							torn_chunks++;
+							break;
+						}
+					}
+				}
+
+				reads++;
+			}
+
+			publisher.unregisterReader(slot);
+		});
+	}
+
+	// The last figure is active, the next one starts the first chunk
+	scene.setNextFigureAsActive();
+	CHECK(scene.getActiveFigureIndex() == 0);
+
+	int max_retired = 0;
+
+	for (int round = 1; round <= round_count; round++) {
+		for (int i = 0; i < Window::FigureChunk::SIZE; i++) {
+			scene.moveActiveFigureTo({ round, scene.getActiveFigureIndex() });
+			scene.setNextFigureAsActive();
+		}
+
+		publisher.publish();
+		max_retired = std::max(max_retired, publisher.countRetired());
+	}
+
+	is_done.store(true);
+
+	for (size_t r = 0; r < readers.size(); r++) {
+		readers[r].join();
+	}
+
+	printf("reads %lld, most retired snapshots %d\n", reads.load(), max_retired);
+
+	CHECK(reads.load() > 0);
+	CHECK(torn_chunks.load() == 0);
+	CHECK(late_versions.load() == 0);
+	CHECK(max_retired < round_count);
+
+	publisher.publish();
+	CHECK(publisher.countRetired() == 0);
+
+	return CHECK_RESULT();
+}
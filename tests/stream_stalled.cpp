@@ -0,0 +1,49 @@
+/*!
+	\file
+	\brief A viewer which never reads costs at most one keyframe
+	\details The scene is big enough for its keyframe to exceed MAX_QUEUED_BYTES, so
+		the keyframe never leaves the queue of the stalled viewer. Edits still have to
+		be encoded as deltas only, instead of a keyframe per flush.
+
+		Build from the repository: g++ -std=c++17 -O2 -pthread -I. tests/stream_stalled.cpp -o stream_stalled
+	\author Crinax
+*/
+#include "check.h"
+#include "../stream.h"
+#include "../commands.h"
+
+int main() {
+	const char* path = "stream_stalled.sock";
+	Window::Scene scene;
+	Window::SceneCommand command;
+
+	Window::parseCommand("generate 400000 4000 4000 7", command);
+	Window::applyCommand(scene, command);
+
+	Window::StreamServer server(scene, path, 0);
+	Window::StreamClient stalled(path);
+
+	while (server.countViewers() < 1) {
+		server.flush();
+	}
+
+	Window::StreamStats stats = server.getStats();
+	CHECK(stats.keyframes == 1);
+	CHECK(stats.bytes_encoded > (long long)Window::StreamServer::MAX_QUEUED_BYTES);
+
+	const char* edits[] = { "rotate-all 0.1", "move 5 5", "next", "grow", "select" };
+
+	for (int step = 0; step < 200; step++) {
+		Window::parseCommand(edits[step % 5], command);
+		Window::applyCommand(scene, command);
+		server.flush();
+	}
+
+	stats = server.getStats();
+	CHECK(stats.keyframes == 1);
+	CHECK(stats.resyncs > 0);
+	CHECK(stats.messages > 200);
+	CHECK(server.countViewers() == 1);
+
+	return CHECK_RESULT();
+}
@@ -0,0 +1,293 @@
+#ifndef PAINTING_TRACE_H
+#define PAINTING_TRACE_H
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <stdexcept>
+
+#include "scene.h"
+#include "export.h"
+#include "commands.h"
+
+namespace Window {
+	// First bytes of trace files, the last one is the format version
+	const unsigned char trace_magic[5] = { 'P', 'T', 'R', 'C', 1 };
+
+	// Record type closing the trace, input records use InputType
+	const unsigned char TRACE_END = 0;
+
+	/*!
+		\brief Hash of everything the user can see in the scene
+		\details Figures with their poses, parents and states, FNV-1a over 64 bits.
+			Equal scenes give equal hashes on the same platform.
+		\param [in] scene {The scene}
+	*/
+	inline unsigned long long hashScene(Window::Scene& scene) {
+		unsigned long long hash = 14695981039346656037ULL;
+		int element_count = scene.countElements();
+
+		auto mix = [&hash](long long value) {
+			for (int b = 0; b < 8; b++) {
+				hash ^= (unsigned long long)value >> (b * 8) & 0xff;
+				hash *= 1099511628211ULL;
+			}
+		};
+
+		mix(element_count);
+		mix(scene.isBlocked());
+
+		for (int i = 0; i < element_count; i++) {
+			Window::Figure figure = scene.getFigure(i);
+			double angle = figure.getAngle();
+			long long angle_bits;
+
+			memcpy(&angle_bits, &angle, sizeof(angle_bits));
+
+			mix(figure.countVertices());
+			mix(figure.getPosition().x);
+			mix(figure.getPosition().y);
+			mix(figure.getRadius());
+			mix(angle_bits);
+			mix(scene.getParentFigure(i));
+			mix(scene.getFigureState(i));
+		}
+
+		return hash;
+	}
+
+	/*!
+		\brief Writes input events of the window with their time into a trace file
+		\details Every record is its type, microseconds since the previous record and
+			the key code or the mouse coords, numbers are LEB128 varints. finish() adds
+			the hash of the scene the events made. The descriptor is owned by the caller.
+		\version 1.0.0
+		\author Crinax
+	*/
+	class TraceRecorder {
+		public:
+			/*!
+				\brief Main constructor for class, the clock starts here
+				\param [in] fd {File descriptor opened for writing}
+			*/
+			TraceRecorder(int fd) : writer(fd) {
+				this->started = std::chrono::steady_clock::now();
+				this->last_time = 0;
+				this->is_finished = false;
+				this->writer.write(Window::trace_magic, sizeof(Window::trace_magic));
+			}
+
+			// Record the event the window is about to handle
+			void record(const Window::InputEvent& event) {
+				this->writeHeader((unsigned char)event.type);
+
+				if (event.type == Window::INPUT_KEY) {
+					this->writeNumber((unsigned)event.key);
+				} else {
+					this->writeNumber((unsigned)event.point.x);
+					this->writeNumber((unsigned)event.point.y);
+				}
+
+				// Input is slow, so the trace is kept on disk in case the window crashes
+				this->writer.flush();
+			}
+
+			/*!
+				\brief Close the trace with the hash of the scene and write it out
+				\param [in] scene {The scene the recorded events were applied to}
+			*/
+			void finish(Window::Scene& scene) {
+				if (this->is_finished) {
+					return;
+				}
+
+				unsigned long long hash = Window::hashScene(scene);
+
+				this->writeHeader(Window::TRACE_END);
+				this->writeNumber(hash);
+				this->writeNumber((unsigned)scene.countElements());
+				this->writer.flush();
+				this->is_finished = true;
+			}
+
+		protected:
+			Window::FileWriter writer;
+			std::chrono::steady_clock::time_point started;
+			unsigned long long last_time;
+			bool is_finished;
+
+			// Type of the record and time since the previous one
+			void writeHeader(unsigned char type) {
+				unsigned long long time = std::chrono::duration_cast<std::chrono::microseconds>(
+					std::chrono::steady_clock::now() - this->started
+				).count();
+
+				this->writer.write(&type, 1);
+				this->writeNumber(time - this->last_time);
+				this->last_time = time;
+			}
+
+			void writeNumber(unsigned long long value) {
+				unsigned char bytes[10];
+				int size = 0;
+
+				do {
+					bytes[size] = value & 0x7f;
+					value >>= 7;
+					bytes[size] |= value != 0 ? 0x80 : 0;
+					size++;
+				} while (value != 0);
+
+				this->writer.write(bytes, size);
+			}
+	};
+
+	// Input event of a trace and microseconds from the start of recording
+	struct TraceEvent {
+		Window::InputEvent event;
+		unsigned long long time;
+	};
+
+	/*!
+		\brief Events of a trace file loaded into memory
+		\version 1.0.0
+		\author Crinax
+	*/
+	class TraceReader {
+		public:
+			/*!
+				\brief Read the whole trace, throws if it can't be read or is broken
+				\param [in] path {Path of the trace file}
+			*/
+			TraceReader(const char* path) {
+				FILE* file = fopen(path, "rb");
+
+				if (file == NULL) {
+					throw std::runtime_error("[ERR] Window::TraceReader: can't open trace");
+				}
+
+				unsigned char buffer[64 * 1024];
+				size_t size;
+
+				while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+					this->data.insert(this->data.end(), buffer, buffer + size);
+				}
+
+				fclose(file);
+
+				this->position = 0;
+				this->scene_hash = 0;
+				this->figure_count = 0;
+				this->is_finished = false;
+				this->parse();
+			}
+
+			const std::vector<Window::TraceEvent>& getEvents() {
+				return this->events;
+			}
+
+			// Returns true if the recorder was finished and the trace holds the scene hash
+			bool isFinished() {
+				return this->is_finished;
+			}
+
+			unsigned long long getSceneHash() {
+				return this->scene_hash;
+			}
+
+			int getFigureCount() {
+				return this->figure_count;
+			}
+
+		protected:
+			std::vector<unsigned char> data;
+			std::vector<Window::TraceEvent> events;
+			size_t position;
+			unsigned long long scene_hash;
+			int figure_count;
+			bool is_finished;
+
+			void parse() {
+				if (this->data.size() < sizeof(Window::trace_magic)
+					|| memcmp(this->data.data(), Window::trace_magic, sizeof(Window::trace_magic)) != 0) {
+					throw std::runtime_error("[ERR] Window::TraceReader: not a trace or unknown version");
+				}
+
+				unsigned long long time = 0;
+
+				this->position = sizeof(Window::trace_magic);
+
+				// Trace of a crashed window has no end record and may end inside a record
+				while (this->position < this->data.size()) {
+					unsigned char type = this->data[this->position++];
+					unsigned long long delta;
+
+					if (!this->readNumber(delta)) {
+						return;
+					}
+
+					time += delta;
+
+					if (type == Window::TRACE_END) {
+						unsigned long long figure_count;
+
+						if (!this->readNumber(this->scene_hash) || !this->readNumber(figure_count)) {
+							throw std::runtime_error("[ERR] Window::TraceReader: trace is truncated");
+						}
+
+						this->figure_count = (int)figure_count;
+						this->is_finished = true;
+						return;
+					}
+
+					if (type < Window::INPUT_KEY || type > Window::INPUT_RIGHT_BUTTON) {
+						throw std::runtime_error("[ERR] Window::TraceReader: unknown record");
+					}
+
+					Window::TraceEvent record = { Window::InputEvent(), time };
+					unsigned long long values[2] = { 0, 0 };
+					int values_count = type == Window::INPUT_KEY ? 1 : 2;
+
+					record.event.type = (Window::InputType)type;
+
+					for (int v = 0; v < values_count; v++) {
+						if (!this->readNumber(values[v])) {
+							return;
+						}
+					}
+
+					if (type == Window::INPUT_KEY) {
+						record.event.key = (int)values[0];
+					} else {
+						record.event.point = { (int)values[0], (int)values[1] };
+					}
+
+					this->events.push_back(record);
+				}
+			}
+
+			// Read LEB128 number, returns false if the data ends before it does
+			bool readNumber(unsigned long long& value) {
+				value = 0;
+
+				for (int shift = 0; this->position < this->data.size(); shift += 7) {
+					unsigned char byte = this->data[this->position++];
+
+					if (shift >= 64) {
+						throw std::runtime_error("[ERR] Window::TraceReader: broken number");
+					}
+
+					value |= (unsigned long long)(byte & 0x7f) << shift;
+
+					if (!(byte & 0x80)) {
+						return true;
+					}
+				}
+
+				return false;
+			}
+	};
+};
+
+#endif
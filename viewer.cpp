@@ -0,0 +1,147 @@
+/*!
+	\file
+	\brief Headless viewer of a scene streamed by the window (main.cpp --stream <socket>)
+	\details Connects to the stream server, rebuilds the scene from its messages and
+		renders it to the software framebuffer after every batch of messages. Prints
+		what it received every second and at the end of the stream. --delay makes the
+		viewer sleep after each batch, to see how the server treats slow viewers.
+
+		viewer [--size WIDTHxHEIGHT] [--delay MS] socket
+
+		Build without the window: g++ -std=c++17 -O2 -pthread viewer.cpp -o viewer
+	\author Crinax
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#include "stream.h"
+#include "raster.h"
+
+double elapsedMs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+	return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+/*!
+	\brief Draw every figure of the mirror like WM_PAINT does
+	\param [in] mirror {The mirror}
+	\param [in] frame {The framebuffer}
+	\param [in] states {Buffer for states of figures}
+*/
+void renderFrame(Window::StreamMirror& mirror, Window::Framebuffer& frame, Window::FigureStates& states) {
+	int element_count = mirror.countElements();
+
+	mirror.getFigureStates(0, element_count, states);
+	frame.clear(Window::background_color);
+
+	for (int i = 0; i < element_count; i++) {
+		Window::Figure figure = mirror.getFigure(i);
+
+		frame.drawFigure(figure, Window::getFigurePen(
+			(states[i] & Window::Scene::FIGURE_ACTIVE) != 0,
+			(states[i] & Window::Scene::FIGURE_SELECTED) != 0
+		));
+	}
+}
+
+int main(int argc, char** argv) {
+	int width = 640;
+	int height = 480;
+	int delay_ms = 0;
+	const char* path = NULL;
+
+	for (int a = 1; a < argc; a++) {
+		if (strcmp(argv[a], "--size") == 0 && a + 1 < argc) {
+			if (sscanf(argv[++a], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+				fprintf(stderr, "wrong frame size: %s\n", argv[a]);
+				return 2;
+			}
+		} else if (strcmp(argv[a], "--delay") == 0 && a + 1 < argc) {
+			delay_ms = atoi(argv[++a]);
+		} else if (argv[a][0] == '-') {
+			path = NULL;
+			break;
+		} else {
+			path = argv[a];
+		}
+	}
+
+	if (path == NULL) {
+		fprintf(stderr, "usage: %s [--size WIDTHxHEIGHT] [--delay MS] socket\n", argv[0]);
+		return 2;
+	}
+
+	try {
+		Window::StreamClient client(path);
+		Window::StreamMirror mirror;
+		Window::Framebuffer frame(width, height);
+		Window::FigureStates states;
+		long long messages = 0;
+		long long frames = 0;
+		double frames_ms = 0;
+		std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point printed = started;
+
+		while (true) {
+			int applied = client.receive(mirror);
+
+			if (applied < 0) {
+				break;
+			}
+
+			if (applied == 0) {
+				continue;
+			}
+
+			std::chrono::steady_clock::time_point before = std::chrono::steady_clock::now();
+
+			renderFrame(mirror, frame, states);
+			frames_ms += elapsedMs(before, std::chrono::steady_clock::now());
+			messages += applied;
+			frames++;
+
+			if (elapsedMs(printed, std::chrono::steady_clock::now()) >= 1000) {
+				printed = std::chrono::steady_clock::now();
+				printf(
+					"version %llu: %d figures, %lld messages, %.1f KB\n",
+					mirror.getVersion(),
+					mirror.countElements(),
+					messages,
+					client.countReceivedBytes() / 1024.0
+				);
+				fflush(stdout);
+			}
+
+			if (delay_ms > 0) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+			}
+		}
+
+		printf(
+			"stream closed at version %llu: %d figures, active %d, selected %d%s\n",
+			mirror.getVersion(),
+			mirror.countElements(),
+			mirror.getActiveFigureIndex(),
+			mirror.getSelectedFigureIndex(),
+			mirror.isBlocked() ? ", locked" : ""
+		);
+		printf(
+			"received: %lld messages, %lld keyframes, %.1f KB in %.1f s\n",
+			messages,
+			mirror.countKeyframes(),
+			client.countReceivedBytes() / 1024.0,
+			elapsedMs(started, std::chrono::steady_clock::now()) / 1e3
+		);
+
+		if (frames > 0) {
+			printf("frames: %lld of %dx%d, avg %.2f ms\n", frames, width, height, frames_ms / frames);
+		}
+	} catch (const std::exception& err) {
+		fprintf(stderr, "%s\n", err.what());
+		return 1;
+	}
+
+	return 0;
+}